@@ -0,0 +1,372 @@
+/*
+ * AsyncQueue.hpp
+ *
+ * C++20 coroutine front-end over the typed ring queue.
+ *
+ * co_await queue.pop() suspends the calling coroutine while the queue is empty and
+ * co_await queue.push(value) suspends it while the queue is full, so no OS thread is
+ * parked in sem_wait. Elements live in the slots of a typed::Queue<T>; suspended
+ * coroutines wait in intrusive FIFO lists threaded through their awaiters, so waiting
+ * costs no allocation beyond the coroutine frame itself.
+ *
+ * The operation that satisfies a waiter resumes it: inline on the completing thread when
+ * the queue has no scheduler, otherwise by handing it to AsyncScheduler::schedule.
+ *
+ */
+
+#ifndef ASYNC_QUEUE_HPP_
+#define ASYNC_QUEUE_HPP_
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "TypedQueue.hpp"
+
+namespace typed {
+
+/*
+ * Decides where a coroutine woken by an AsyncQueue runs.
+ */
+class AsyncScheduler {
+public:
+    virtual ~AsyncScheduler() = default;
+
+    /*
+     * Arranges for handle to be resumed. Must not resume it before returning.
+     */
+    virtual void schedule(std::coroutine_handle<> handle) = 0;
+};
+
+/*
+ * AsyncScheduler resuming coroutines on a fixed set of worker threads.
+ */
+class ThreadPoolScheduler : public AsyncScheduler {
+public:
+    /*
+     * Starts num_threads worker threads.
+     */
+    explicit ThreadPoolScheduler(size_t num_threads) {
+        for (size_t i = 0; i < num_threads; i++) {
+            workers_.emplace_back([this] { run(); });
+        }
+    }
+
+    ThreadPoolScheduler(const ThreadPoolScheduler&) = delete;
+    ThreadPoolScheduler& operator=(const ThreadPoolScheduler&) = delete;
+
+    /*
+     * Resumes every coroutine already scheduled, then joins the worker threads.
+     */
+    ~ThreadPoolScheduler() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        ready_cond_.notify_all();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    void schedule(std::coroutine_handle<> handle) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready_.push_back(handle);
+        }
+        ready_cond_.notify_one();
+    }
+
+    /*
+     * Awaitable moving the calling coroutine onto one of the worker threads.
+     */
+    auto yield() {
+        struct YieldAwaiter {
+            ThreadPoolScheduler& scheduler;
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle) {
+                scheduler.schedule(handle);
+            }
+
+            void await_resume() const noexcept {
+            }
+        };
+        return YieldAwaiter{*this};
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            ready_cond_.wait(lock, [this] { return stopping_ || !ready_.empty(); });
+            if (ready_.empty()) {
+                return;
+            }
+            std::coroutine_handle<> handle = ready_.front();
+            ready_.pop_front();
+            lock.unlock();
+            handle.resume();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable ready_cond_;
+    std::deque<std::coroutine_handle<>> ready_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+/*
+ * Fixed-capacity FIFO queue of T whose push and pop are awaited by coroutines.
+ * The queue must outlive every coroutine suspended on it.
+ */
+template <typename T>
+class AsyncQueue {
+    /*
+     * Intrusive FIFO list of suspended awaiters.
+     */
+    template <typename Awaiter>
+    struct WaiterList {
+        Awaiter* head = nullptr;
+        Awaiter* tail = nullptr;
+
+        void push_back(Awaiter* waiter) {
+            waiter->next_ = nullptr;
+            if (tail == nullptr) {
+                head = waiter;
+            } else {
+                tail->next_ = waiter;
+            }
+            tail = waiter;
+        }
+
+        Awaiter* pop_front() {
+            Awaiter* waiter = head;
+            if (waiter != nullptr) {
+                head = waiter->next_;
+                if (head == nullptr) {
+                    tail = nullptr;
+                }
+            }
+            return waiter;
+        }
+    };
+
+public:
+    /*
+     * Awaiter returned by pop(); resumes with the front element.
+     */
+    class PopAwaiter {
+    public:
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            return owner_.suspendPop(*this, handle);
+        }
+
+        T await_resume() {
+            return std::move(*value_);
+        }
+
+    private:
+        friend class AsyncQueue;
+        friend struct WaiterList<PopAwaiter>;
+
+        explicit PopAwaiter(AsyncQueue& owner) : owner_(owner) {
+        }
+
+        AsyncQueue& owner_;
+        std::optional<T> value_;
+        std::coroutine_handle<> handle_;
+        PopAwaiter* next_ = nullptr;
+    };
+
+    /*
+     * Awaiter returned by push(); resumes once the element is in the queue or with a consumer.
+     */
+    class PushAwaiter {
+    public:
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            return owner_.suspendPush(*this, handle);
+        }
+
+        void await_resume() const noexcept {
+        }
+
+    private:
+        friend class AsyncQueue;
+        friend struct WaiterList<PushAwaiter>;
+
+        PushAwaiter(AsyncQueue& owner, T&& value) : owner_(owner), value_(std::move(value)) {
+        }
+
+        AsyncQueue& owner_;
+        T value_;
+        std::coroutine_handle<> handle_;
+        PushAwaiter* next_ = nullptr;
+    };
+
+    /*
+     * Creates a queue for at most capacity elements. Woken coroutines are resumed inline
+     * by the thread completing their operation, or through scheduler when one is given.
+     */
+    explicit AsyncQueue(size_t capacity, AsyncScheduler* scheduler = nullptr)
+        : queue_(capacity), scheduler_(scheduler) {
+    }
+
+    AsyncQueue(const AsyncQueue&) = delete;
+    AsyncQueue& operator=(const AsyncQueue&) = delete;
+
+    /*
+     * co_await pop() yields the front element, suspending while the queue is empty.
+     */
+    PopAwaiter pop() {
+        return PopAwaiter(*this);
+    }
+
+    /*
+     * co_await push(value) appends value, suspending while the queue is full.
+     * A suspended consumer receives the value directly.
+     */
+    PushAwaiter push(T value) {
+        return PushAwaiter(*this, std::move(value));
+    }
+
+    /*
+     * Appends value without suspending. Returns false if the queue is full.
+     * Callable from plain threads; wakes a waiting consumer.
+     */
+    bool try_push(T value) {
+        std::coroutine_handle<> woken;
+        bool pushed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pushed = putLocked(value, woken);
+        }
+        wake(woken);
+        return pushed;
+    }
+
+    /*
+     * Removes the front element without suspending.
+     * Returns std::nullopt if the queue is empty. Wakes a waiting producer.
+     */
+    std::optional<T> try_pop() {
+        std::optional<T> value;
+        std::coroutine_handle<> woken;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            woken = takeLocked(value);
+        }
+        wake(woken);
+        return value;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+
+    size_t capacity() const {
+        return queue_.capacity();
+    }
+
+private:
+    /*
+     * Takes the front element into out and refills the freed slot from the first waiting
+     * producer. Returns that producer's handle, or a null handle if none was waiting.
+     */
+    std::coroutine_handle<> takeLocked(std::optional<T>& out) {
+        out = queue_.try_pop();
+        PushAwaiter* pusher = push_waiters_.pop_front();
+        if (pusher == nullptr) {
+            return {};
+        }
+        if (out.has_value()) {
+            queue_.push(std::move(pusher->value_));
+        } else {
+            out.emplace(std::move(pusher->value_));
+        }
+        return pusher->handle_;
+    }
+
+    /*
+     * Hands value to the first waiting consumer, setting woken to its handle, or appends it.
+     * Returns false, leaving value untouched, if the queue is full.
+     */
+    bool putLocked(T& value, std::coroutine_handle<>& woken) {
+        if (PopAwaiter* popper = pop_waiters_.pop_front()) {
+            popper->value_.emplace(std::move(value));
+            woken = popper->handle_;
+            return true;
+        }
+        return queue_.push(std::move(value));
+    }
+
+    bool suspendPop(PopAwaiter& awaiter, std::coroutine_handle<> handle) {
+        std::coroutine_handle<> woken;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            woken = takeLocked(awaiter.value_);
+            if (!awaiter.value_.has_value()) {
+                awaiter.handle_ = handle;
+                pop_waiters_.push_back(&awaiter);
+                return true;
+            }
+        }
+        wake(woken);
+        return false;
+    }
+
+    bool suspendPush(PushAwaiter& awaiter, std::coroutine_handle<> handle) {
+        std::coroutine_handle<> woken;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!putLocked(awaiter.value_, woken)) {
+                awaiter.handle_ = handle;
+                push_waiters_.push_back(&awaiter);
+                return true;
+            }
+        }
+        wake(woken);
+        return false;
+    }
+
+    void wake(std::coroutine_handle<> handle) {
+        if (!handle) {
+            return;
+        }
+        if (scheduler_ != nullptr) {
+            scheduler_->schedule(handle);
+        } else {
+            handle.resume();
+        }
+    }
+
+    std::mutex mutex_;
+    Queue<T> queue_;
+    AsyncScheduler* scheduler_;
+    WaiterList<PopAwaiter> pop_waiters_;
+    WaiterList<PushAwaiter> push_waiters_;
+};
+
+} // namespace typed
+
+#endif /* ASYNC_QUEUE_HPP_ */
@@ -0,0 +1,214 @@
+/*
+ * BenchBlockingQueue.c
+ *
+ * Producer/consumer throughput benchmark for the blocking queue implementations with
+ * per-operation hardware counters.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "BlockingQueue.h"
+#include "BlockingQueueProducer.h"
+#include "FlatCombiningBlockingQueue.h"
+#include "PerfCounters.h"
+#include "TwoLockBlockingQueue.h"
+
+
+#define BENCH_QUEUE_SIZE 64
+#define BENCH_ITEMS_PER_THREAD 200000L
+#define MAX_THREADS 64
+#define BENCH_PRODUCER_BATCH 32
+#define BENCH_PRODUCER_DELAY_US 1000
+
+/*
+ * Operations of one blocking queue implementation under test.
+ */
+typedef struct BenchQueueOps {
+    const char *name;
+    void *(*create)(int max_size);
+    bool (*enq)(void *queue, void *element);
+    void *(*deq)(void *queue);
+    void (*destroy)(void *queue);
+} BenchQueueOps;
+
+/*
+ * Shared state for one benchmark run.
+ */
+typedef struct BenchRun {
+    const BenchQueueOps *ops;
+    void *queue;
+    long items;
+} BenchRun;
+
+static void *createBlockingQueue(int max_size) {
+    return new_BlockingQueue(max_size);
+}
+
+static bool enqBlockingQueue(void *queue, void *element) {
+    return BlockingQueue_enq(queue, element);
+}
+
+static void *deqBlockingQueue(void *queue) {
+    return BlockingQueue_deq(queue);
+}
+
+static void destroyBlockingQueue(void *queue) {
+    BlockingQueue_destroy(queue);
+}
+
+static void *createHandoffBlockingQueue(int max_size) {
+    return new_BlockingQueueHandoff(max_size);
+}
+
+static void *createTwoLockBlockingQueue(int max_size) {
+    return new_TwoLockBlockingQueue(max_size);
+}
+
+static bool enqTwoLockBlockingQueue(void *queue, void *element) {
+    return TwoLockBlockingQueue_enq(queue, element);
+}
+
+static void *deqTwoLockBlockingQueue(void *queue) {
+    return TwoLockBlockingQueue_deq(queue);
+}
+
+static void destroyTwoLockBlockingQueue(void *queue) {
+    TwoLockBlockingQueue_destroy(queue);
+}
+
+static void *createFlatCombiningBlockingQueue(int max_size) {
+    return new_FlatCombiningBlockingQueue(max_size);
+}
+
+static bool enqFlatCombiningBlockingQueue(void *queue, void *element) {
+    return FlatCombiningBlockingQueue_enq(queue, element);
+}
+
+static void *deqFlatCombiningBlockingQueue(void *queue) {
+    return FlatCombiningBlockingQueue_deq(queue);
+}
+
+static void destroyFlatCombiningBlockingQueue(void *queue) {
+    FlatCombiningBlockingQueue_destroy(queue);
+}
+
+/*
+ * Every implementation the benchmark compares.
+ */
+static const BenchQueueOps implementations[] = {
+    { "BlockingQueue", createBlockingQueue, enqBlockingQueue, deqBlockingQueue, destroyBlockingQueue },
+    { "HandoffBlockingQueue", createHandoffBlockingQueue, enqBlockingQueue, deqBlockingQueue, destroyBlockingQueue },
+    { "TwoLockBlockingQueue", createTwoLockBlockingQueue, enqTwoLockBlockingQueue, deqTwoLockBlockingQueue,
+            destroyTwoLockBlockingQueue },
+    { "FlatCombiningBlockingQueue", createFlatCombiningBlockingQueue, enqFlatCombiningBlockingQueue,
+            deqFlatCombiningBlockingQueue, destroyFlatCombiningBlockingQueue },
+};
+
+/*
+ * Returns the current monotonic time in nanoseconds.
+ */
+static double nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * Producer thread: enqueues run->items non-NULL elements.
+ */
+static void *producer(void *arg) {
+    BenchRun *run = (BenchRun *) arg;
+    for (long i = 1; i <= run->items; i++) {
+        run->ops->enq(run->queue, (void *) i);
+    }
+    return NULL;
+}
+
+/*
+ * Producer thread staging run->items elements through its own BlockingQueueProducer handle.
+ */
+static void *bufferedProducer(void *arg) {
+    BenchRun *run = (BenchRun *) arg;
+    BlockingQueueProducer *handle = new_BlockingQueueProducer(run->queue, BENCH_PRODUCER_BATCH,
+            BENCH_PRODUCER_DELAY_US);
+    for (long i = 1; i <= run->items; i++) {
+        BlockingQueueProducer_enq(handle, (void *) i);
+    }
+    BlockingQueueProducer_destroy(handle);
+    return NULL;
+}
+
+/*
+ * Consumer thread: dequeues run->items elements.
+ */
+static void *consumer(void *arg) {
+    BenchRun *run = (BenchRun *) arg;
+    for (long i = 1; i <= run->items; i++) {
+        run->ops->deq(run->queue);
+    }
+    return NULL;
+}
+
+/*
+ * Runs pairs producer and pairs consumer threads through one queue and prints the
+ * time and counters per transferred element.
+ */
+static void benchPairs(const BenchQueueOps *ops, int pairs, long items, bool buffered) {
+    void *queue = ops->create(BENCH_QUEUE_SIZE);
+    PerfCounters *counters = new_PerfCounters();
+    if (queue == NULL || counters == NULL) {
+        if (queue != NULL) {
+            ops->destroy(queue);
+        }
+        if (counters != NULL) {
+            PerfCounters_destroy(counters);
+        }
+        return;
+    }
+
+    BenchRun run = { ops, queue, items };
+    pthread_t threads[2 * MAX_THREADS];
+
+    PerfCounters_start(counters);
+    double start = nowNs();
+    for (int i = 0; i < pairs; i++) {
+        pthread_create(&threads[2 * i], NULL, buffered ? bufferedProducer : producer, &run);
+        pthread_create(&threads[2 * i + 1], NULL, consumer, &run);
+    }
+    for (int i = 0; i < 2 * pairs; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = nowNs() - start;
+    PerfCounters_stop(counters);
+
+    long ops_count = pairs * items;
+    char label[64];
+    snprintf(label, sizeof(label), "%s%s %d:%d", ops->name, buffered ? "+Producer" : "", pairs, pairs);
+    printf("%-36s %8.1f ns/op %10.0f ops/s\n", label, elapsed / ops_count, ops_count / (elapsed / 1e9));
+    PerfCounters_print(counters, label, ops_count);
+
+    PerfCounters_destroy(counters);
+    ops->destroy(queue);
+}
+
+int main(int argc, char *argv[]) {
+    long items = argc > 1 ? atol(argv[1]) : BENCH_ITEMS_PER_THREAD;
+    if (items <= 0) {
+        items = BENCH_ITEMS_PER_THREAD;
+    }
+
+    int pairs[] = { 1, 4, 16, 32 };
+    for (size_t p = 0; p < sizeof(pairs) / sizeof(pairs[0]); p++) {
+        for (size_t i = 0; i < sizeof(implementations) / sizeof(implementations[0]); i++) {
+            benchPairs(&implementations[i], pairs[p], items, false);
+        }
+        benchPairs(&implementations[0], pairs[p], items, true);
+    }
+    printf("----------------\n");
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * BenchBroadcastRing.c
+ *
+ * Fan-out benchmark: one publisher delivering every event to several consumers, either by
+ * copying it into one BlockingQueue per consumer or by writing it once to a BroadcastRing.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "BlockingQueue.h"
+#include "BroadcastRing.h"
+#include "PerfCounters.h"
+
+
+#define BENCH_RING_SIZE 1024
+#define BENCH_EVENTS 500000L
+#define BENCH_CONSUMERS 4
+
+/*
+ * Number of events each consumer thread reads.
+ */
+static long events;
+
+/*
+ * Returns the current monotonic time in nanoseconds.
+ */
+static double nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * Consumer thread reading from its own BlockingQueue.
+ */
+static void *queueConsumer(void *arg) {
+    BlockingQueue *queue = (BlockingQueue *) arg;
+    for (long i = 0; i < events; i++) {
+        BlockingQueue_deq(queue);
+    }
+    return NULL;
+}
+
+/*
+ * Consumer thread reading from a BroadcastRing cursor.
+ */
+static void *ringConsumer(void *arg) {
+    BroadcastConsumer *consumer = (BroadcastConsumer *) arg;
+    for (long i = 0; i < events; i++) {
+        BroadcastConsumer_wait(consumer);
+        BroadcastConsumer_commit(consumer);
+    }
+    return NULL;
+}
+
+/*
+ * Copies every event into one BlockingQueue per consumer.
+ */
+static void benchQueues(PerfCounters *counters) {
+    BlockingQueue *queues[BENCH_CONSUMERS];
+    pthread_t threads[BENCH_CONSUMERS];
+
+    PerfCounters_start(counters);
+    double start = nowNs();
+    for (int c = 0; c < BENCH_CONSUMERS; c++) {
+        queues[c] = new_BlockingQueue(BENCH_RING_SIZE);
+        pthread_create(&threads[c], NULL, queueConsumer, queues[c]);
+    }
+    for (long i = 1; i <= events; i++) {
+        for (int c = 0; c < BENCH_CONSUMERS; c++) {
+            BlockingQueue_enq(queues[c], (void *) i);
+        }
+    }
+    for (int c = 0; c < BENCH_CONSUMERS; c++) {
+        pthread_join(threads[c], NULL);
+        BlockingQueue_destroy(queues[c]);
+    }
+    double elapsed = nowNs() - start;
+    PerfCounters_stop(counters);
+
+    printf("%d x BlockingQueue fan-out: %8.1f ns/event\n", BENCH_CONSUMERS, elapsed / events);
+    PerfCounters_print(counters, "BlockingQueue fan-out", events);
+}
+
+/*
+ * Publishes every event once to a BroadcastRing read by all consumers.
+ */
+static void benchRing(PerfCounters *counters) {
+    BroadcastRing *ring = new_BroadcastRing(BENCH_RING_SIZE);
+    pthread_t threads[BENCH_CONSUMERS];
+
+    PerfCounters_start(counters);
+    double start = nowNs();
+    for (int c = 0; c < BENCH_CONSUMERS; c++) {
+        BroadcastConsumer *consumer = BroadcastRing_addConsumer(ring, NULL, 0);
+        pthread_create(&threads[c], NULL, ringConsumer, consumer);
+    }
+    for (long i = 1; i <= events; i++) {
+        BroadcastRing_publish(ring, (void *) i);
+    }
+    for (int c = 0; c < BENCH_CONSUMERS; c++) {
+        pthread_join(threads[c], NULL);
+    }
+    double elapsed = nowNs() - start;
+    PerfCounters_stop(counters);
+
+    printf("BroadcastRing multicast:    %8.1f ns/event\n", elapsed / events);
+    PerfCounters_print(counters, "BroadcastRing multicast", events);
+    BroadcastRing_destroy(ring);
+}
+
+int main(int argc, char *argv[]) {
+    events = argc > 1 ? atol(argv[1]) : BENCH_EVENTS;
+    if (events <= 0) {
+        events = BENCH_EVENTS;
+    }
+
+    PerfCounters *counters = new_PerfCounters();
+    if (counters == NULL) {
+        return 1;
+    }
+
+    benchQueues(counters);
+    benchRing(counters);
+    printf("----------------\n");
+
+    PerfCounters_destroy(counters);
+    return 0;
+}
@@ -0,0 +1,67 @@
+/*
+ * BenchDelayQueue.c
+ *
+ * Insert and cancel cost of DelayQueue with millions of pending timers.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "DelayQueue.h"
+#include "PerfCounters.h"
+
+
+#define BENCH_TIMERS 2000000L
+
+/*
+ * Returns the current monotonic time in nanoseconds.
+ */
+static double nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char *argv[]) {
+    long timers = argc > 1 ? atol(argv[1]) : BENCH_TIMERS;
+    if (timers <= 0) {
+        timers = BENCH_TIMERS;
+    }
+
+    DelayQueue *queue = new_DelayQueue(1);
+    DelayTimerId *ids = (DelayTimerId *) malloc(sizeof(DelayTimerId) * timers);
+    PerfCounters *counters = new_PerfCounters();
+    if (queue == NULL || ids == NULL || counters == NULL) {
+        return 1;
+    }
+
+    /* Spread due times from one second to about a day so every wheel level is used. */
+    PerfCounters_start(counters);
+    double start = nowNs();
+    for (long i = 0; i < timers; i++) {
+        ids[i] = DelayQueue_enq(queue, (void *) (i + 1), 1000 + (uint64_t) (i * 7919) % 86400000);
+    }
+    double inserted = nowNs();
+    PerfCounters_stop(counters);
+    printf("DelayQueue enq:    %6.1f ns/op, %d pending, %zu bytes/timer\n", (inserted - start) / timers,
+            DelayQueue_size(queue), sizeof(DelayTimer));
+    PerfCounters_print(counters, "enq", timers);
+
+    PerfCounters_start(counters);
+    start = nowNs();
+    for (long i = 0; i < timers; i++) {
+        DelayQueue_cancel(queue, ids[i]);
+    }
+    double cancelled = nowNs();
+    PerfCounters_stop(counters);
+    printf("DelayQueue cancel: %6.1f ns/op\n", (cancelled - start) / timers);
+    PerfCounters_print(counters, "cancel", timers);
+    printf("----------------\n");
+
+    PerfCounters_destroy(counters);
+    free(ids);
+    DelayQueue_destroy(queue);
+    return 0;
+}
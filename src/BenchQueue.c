@@ -0,0 +1,101 @@
+/*
+ * BenchQueue.c
+ *
+ * Simple throughput benchmark comparing the out-of-line Queue functions in Queue.o
+ * against the inline fast path from QueueInline.h.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "PerfCounters.h"
+#include "Queue.h"
+#include "QueueInline.h"
+
+
+#define BENCH_QUEUE_SIZE 16
+#define BENCH_ITERATIONS 20000000L
+
+/*
+ * Sink for dequeued values so the compiler cannot discard the benchmark loops.
+ */
+static volatile void *sink;
+
+/*
+ * Returns the current monotonic time in nanoseconds.
+ */
+static double nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * Enqueues and dequeues one element per iteration through the out-of-line functions.
+ */
+static double benchOutOfLine(Queue *queue, long iterations) {
+    double start = nowNs();
+    for (long i = 0; i < iterations; i++) {
+        Queue_enq(queue, (void *) (i + 1));
+        if (!Queue_isEmpty(queue)) {
+            sink = Queue_deq(queue);
+        }
+    }
+    return (nowNs() - start) / iterations;
+}
+
+/*
+ * Enqueues and dequeues one element per iteration through the inline fast path.
+ */
+static double benchInline(Queue *queue, long iterations) {
+    double start = nowNs();
+    for (long i = 0; i < iterations; i++) {
+        QueueInline_enq(queue, (void *) (i + 1));
+        if (!QueueInline_isEmpty(queue)) {
+            sink = QueueInline_deq(queue);
+        }
+    }
+    return (nowNs() - start) / iterations;
+}
+
+int main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? atol(argv[1]) : BENCH_ITERATIONS;
+    if (iterations <= 0) {
+        iterations = BENCH_ITERATIONS;
+    }
+
+    Queue *queue = new_Queue(BENCH_QUEUE_SIZE);
+    if (queue == NULL) {
+        return 1;
+    }
+
+    /* Warm up both paths before measuring. */
+    benchOutOfLine(queue, iterations / 10);
+    benchInline(queue, iterations / 10);
+
+    PerfCounters *counters = new_PerfCounters();
+    if (counters == NULL) {
+        Queue_destroy(queue);
+        return 1;
+    }
+
+    PerfCounters_start(counters);
+    double outOfLine = benchOutOfLine(queue, iterations);
+    PerfCounters_stop(counters);
+    printf("Queue enq+deq out-of-line: %6.2f ns/op\n", outOfLine);
+    PerfCounters_print(counters, "out-of-line", iterations);
+
+    PerfCounters_start(counters);
+    double inlined = benchInline(queue, iterations);
+    PerfCounters_stop(counters);
+    printf("Queue enq+deq inline:      %6.2f ns/op\n", inlined);
+    PerfCounters_print(counters, "inline", iterations);
+
+    printf("Speedup:                   %6.2fx\n----------------\n", outOfLine / inlined);
+
+    PerfCounters_destroy(counters);
+    Queue_destroy(queue);
+    return 0;
+}
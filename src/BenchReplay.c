@@ -0,0 +1,144 @@
+/*
+ * BenchReplay.c
+ *
+ * Replays a recorded queue trace against each blocking queue implementation and reports
+ * throughput and per-operation latency.
+ *
+ * Usage: ./BenchReplay [trace-file]
+ * Without a trace file, a bursty producer/consumer trace is recorded first. To capture real
+ * traffic, call QueueTrace_start and QueueTrace_stop around it, then QueueTrace_collect and
+ * QueueTrace_save.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "BlockingQueue.h"
+#include "QueueReplay.h"
+#include "QueueTrace.h"
+#include "TwoLockBlockingQueue.h"
+
+
+#define BENCH_QUEUE_SIZE 64
+#define BENCH_THREADS 4
+#define BENCH_BURSTS 200
+#define BENCH_BURST_SIZE 128
+#define BENCH_BURST_GAP_US 200
+
+static void *createBlockingQueue(size_t max_size) {
+    return new_BlockingQueue(max_size);
+}
+
+static bool enqBlockingQueue(void *queue, void *element) {
+    return BlockingQueue_enq(queue, element);
+}
+
+static void *deqBlockingQueue(void *queue) {
+    return BlockingQueue_deq(queue);
+}
+
+static void destroyBlockingQueue(void *queue) {
+    BlockingQueue_destroy(queue);
+}
+
+static void *createTwoLockBlockingQueue(size_t max_size) {
+    return new_TwoLockBlockingQueue((int) max_size);
+}
+
+static bool enqTwoLockBlockingQueue(void *queue, void *element) {
+    return TwoLockBlockingQueue_enq(queue, element);
+}
+
+static void *deqTwoLockBlockingQueue(void *queue) {
+    return TwoLockBlockingQueue_deq(queue);
+}
+
+static void destroyTwoLockBlockingQueue(void *queue) {
+    TwoLockBlockingQueue_destroy(queue);
+}
+
+/*
+ * Every implementation the trace is replayed against.
+ */
+static const QueueReplayOps implementations[] = {
+    { "BlockingQueue", createBlockingQueue, enqBlockingQueue, deqBlockingQueue, destroyBlockingQueue },
+    { "TwoLockBlockingQueue", createTwoLockBlockingQueue, enqTwoLockBlockingQueue, deqTwoLockBlockingQueue,
+            destroyTwoLockBlockingQueue },
+};
+
+/*
+ * Producer thread: enqueues bursts of elements separated by idle gaps.
+ */
+static void *burstyProducer(void *arg) {
+    BlockingQueue *queue = (BlockingQueue *) arg;
+    for (long burst = 0; burst < BENCH_BURSTS; burst++) {
+        for (long i = 1; i <= BENCH_BURST_SIZE; i++) {
+            BlockingQueue_enq(queue, (void *) i);
+        }
+        usleep(BENCH_BURST_GAP_US);
+    }
+    return NULL;
+}
+
+/*
+ * Consumer thread: dequeues as many elements as one producer enqueues.
+ */
+static void *steadyConsumer(void *arg) {
+    BlockingQueue *queue = (BlockingQueue *) arg;
+    for (long i = 0; i < BENCH_BURSTS * BENCH_BURST_SIZE; i++) {
+        BlockingQueue_deq(queue);
+    }
+    return NULL;
+}
+
+/*
+ * Records a trace of BENCH_THREADS bursty producers and as many consumers on one BlockingQueue.
+ */
+static QueueTraceEvent *recordTrace(size_t *count) {
+    BlockingQueue *queue = new_BlockingQueue(BENCH_QUEUE_SIZE);
+    pthread_t threads[2 * BENCH_THREADS];
+
+    QueueTrace_start();
+    for (int i = 0; i < BENCH_THREADS; i++) {
+        pthread_create(&threads[2 * i], NULL, burstyProducer, queue);
+        pthread_create(&threads[2 * i + 1], NULL, steadyConsumer, queue);
+    }
+    for (int i = 0; i < 2 * BENCH_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    QueueTrace_stop();
+
+    BlockingQueue_destroy(queue);
+    return QueueTrace_collect(count);
+}
+
+int main(int argc, char *argv[]) {
+    size_t count;
+    QueueTraceEvent *events = argc > 1 ? QueueTrace_load(argv[1], &count) : recordTrace(&count);
+    if (events == NULL) {
+        fprintf(stderr, "No trace events%s%s\n", argc > 1 ? " in " : "", argc > 1 ? argv[1] : "");
+        return 1;
+    }
+    printf("Replaying %zu events\n", count);
+
+    for (int thinkTime = 1; thinkTime >= 0; thinkTime--) {
+        for (size_t i = 0; i < sizeof(implementations) / sizeof(implementations[0]); i++) {
+            QueueReplayResult result;
+            if (!QueueReplay_run(events, count, &implementations[i], BENCH_QUEUE_SIZE, thinkTime, &result)) {
+                fprintf(stderr, "Replay against %s failed\n", implementations[i].name);
+                continue;
+            }
+            char label[64];
+            snprintf(label, sizeof(label), "%s%s", implementations[i].name, thinkTime ? "" : " (no think time)");
+            printf("%-40s %9ld ops %10.0f ops/s p50=%.0fns p99=%.0fns max=%.0fns\n", label, result.operations,
+                    result.throughput, result.latencyP50Ns, result.latencyP99Ns, result.latencyMaxNs);
+        }
+    }
+    printf("----------------\n");
+
+    free(events);
+    return 0;
+}
@@ -6,12 +6,17 @@
  */
 
 #include <stddef.h>
+#include <errno.h>
 #include <pthread.h>
+#include <sched.h>
 #include <semaphore.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <limits.h>
 
 #include "BlockingQueue.h"
+#include "QueueTrace.h"
+#include "ReservedRing.h"
 
 /*
  * The functions below all return default values and don't work.
@@ -19,38 +24,310 @@
  */
 
 
-BlockingQueue *new_BlockingQueue(int max_size) {
+/*
+ * Creates the BlockingQueue, allocating its slots on the heap or as reserved address space.
+ */
+static BlockingQueue *createBlockingQueue(size_t max_size, BlockingQueuePolicy policy, void (*on_drop)(void *element),
+        bool reserved, bool handoff) {
+    /* An overflow policy needs a slot to admit or evict into; only blocking queues may have none. */
+    if (max_size > SEM_VALUE_MAX || (max_size == 0 && policy != BLOCKING_QUEUE_BLOCK)) {
+        return NULL;
+    }
+
     BlockingQueue* queue = (BlockingQueue*) malloc(sizeof(BlockingQueue));
     if (queue == NULL) {
         free(queue);
         return NULL;
     }
 
-    queue->array = (void**) malloc(sizeof(void*) * max_size);
+    queue->array = reserved ? ReservedRing_reserve(max_size) : (void**) malloc(sizeof(void*) * (max_size > 0 ? max_size : 1));
     if (queue->array == NULL) {
-        free(queue->array);
+        free(queue);
         return NULL;
     }
 
     queue->maxSize = max_size;
     queue->size = 0;
+    queue->head = 0;
+    queue->reserved = reserved;
+    queue->policy = policy;
+    queue->onDrop = on_drop;
+    atomic_init(&(queue->rejected), 0);
+    atomic_init(&(queue->dropped), 0);
+    queue->handoff = handoff;
+    queue->consumers = NULL;
+    queue->consumersTail = NULL;
+    queue->producers = NULL;
+    queue->producersTail = NULL;
     pthread_mutex_init(&(queue->mutex), NULL);
     sem_init(&(queue->full), 0, 0);
-    sem_init(&(queue->empty), 0, max_size);
+    sem_init(&(queue->empty), 0, (unsigned int) max_size);
 
     return queue;
 }
 
+BlockingQueue *new_BlockingQueue(size_t max_size) {
+    return createBlockingQueue(max_size, BLOCKING_QUEUE_BLOCK, NULL, false, false);
+}
+
+BlockingQueue *new_BlockingQueueWithPolicy(size_t max_size, BlockingQueuePolicy policy, void (*on_drop)(void *element)) {
+    return createBlockingQueue(max_size, policy, on_drop, false, false);
+}
+
+BlockingQueue *new_BlockingQueueReserved(size_t max_size, BlockingQueuePolicy policy, void (*on_drop)(void *element)) {
+    return createBlockingQueue(max_size, policy, on_drop, true, false);
+}
+
+BlockingQueue *new_BlockingQueueHandoff(size_t max_size) {
+    return createBlockingQueue(max_size, BLOCKING_QUEUE_BLOCK, NULL, false, true);
+}
+
+BlockingQueue *new_BlockingQueueSynchronous() {
+    return new_BlockingQueueHandoff(0);
+}
+
+/*
+ * Returns the array index of the slot offset elements after the head.
+ * Must be called with the mutex held.
+ */
+static size_t slotIndex(BlockingQueue* this, size_t offset) {
+    size_t index = this->head + offset;
+    return index >= this->maxSize ? index - this->maxSize : index;
+}
+
+/*
+ * Appends element at the tail without tracing, for elements whose producer records its own enqueue.
+ * Must be called with the mutex held and a free slot claimed.
+ */
+static void storeTail(BlockingQueue* this, void* element) {
+    this->array[slotIndex(this, this->size)] = element;
+    this->size++;
+}
+
+/*
+ * Appends element at the tail. Must be called with the mutex held and a free slot claimed.
+ */
+static void pushTail(BlockingQueue* this, void* element) {
+    storeTail(this, element);
+    if (QueueTrace_enabled()) {
+        QueueTrace_record(this, QUEUE_TRACE_ENQ);
+    }
+}
+
+/*
+ * Waits on sem like sem_wait, first recording a blocked event when tracing finds it at zero.
+ */
+static void waitFor(BlockingQueue* this, sem_t* sem, QueueTraceType blocked) {
+    if (QueueTrace_enabled()) {
+        if (sem_trywait(sem) == 0) {
+            return;
+        }
+        QueueTrace_record(this, blocked);
+    }
+    sem_wait(sem);
+}
+
+/*
+ * Removes and returns the element at the head without tracing, for clears and evictions that
+ * no consumer performs. Must be called with the mutex held and an element claimed.
+ */
+static void* popHead(BlockingQueue* this) {
+    void* data = this->array[this->head];
+    this->head = slotIndex(this, 1);
+    this->size--;
+    if (this->reserved) {
+        ReservedRing_advanced(this->array, this->maxSize, this->head, this->size);
+    }
+    return data;
+}
+
+/*
+ * Dequeues and returns the element at the head. Must be called with the mutex held and an element claimed.
+ */
+static void* takeHead(BlockingQueue* this) {
+    void* data = popHead(this);
+    if (QueueTrace_enabled()) {
+        QueueTrace_record(this, QUEUE_TRACE_DEQ);
+    }
+    return data;
+}
+
+/*
+ * Appends waiter to the list with the given head and tail. Must be called with the mutex held.
+ */
+static void appendWaiter(BlockingQueueWaiter** head, BlockingQueueWaiter** tail, BlockingQueueWaiter* waiter) {
+    waiter->next = NULL;
+    if (*tail == NULL) {
+        *head = waiter;
+    } else {
+        (*tail)->next = waiter;
+    }
+    *tail = waiter;
+}
+
+/*
+ * Unlinks and returns the first waiter of the list, or NULL. Must be called with the mutex held.
+ */
+static BlockingQueueWaiter* takeWaiter(BlockingQueueWaiter** head, BlockingQueueWaiter** tail) {
+    BlockingQueueWaiter *waiter = *head;
+    if (waiter != NULL) {
+        *head = waiter->next;
+        if (*head == NULL) {
+            *tail = NULL;
+        }
+    }
+    return waiter;
+}
+
+/*
+ * Parks the calling thread on the given list, releasing the mutex, until another thread completes
+ * its operation, then records that operation as done by the calling thread.
+ * Must be called with the mutex held. Returns the waiter's element as left by that thread.
+ */
+static void* park(BlockingQueue* this, BlockingQueueWaiter** head, BlockingQueueWaiter** tail, void* element,
+        QueueTraceType blocked, QueueTraceType done) {
+    BlockingQueueWaiter waiter;
+    waiter.element = element;
+    sem_init(&(waiter.ready), 0, 0);
+    appendWaiter(head, tail, &waiter);
+    if (QueueTrace_enabled()) {
+        QueueTrace_record(this, blocked);
+    }
+    pthread_mutex_unlock(&(this->mutex));
+
+    while (sem_wait(&(waiter.ready)) != 0 && errno == EINTR) {
+    }
+    sem_destroy(&(waiter.ready));
+    if (QueueTrace_enabled()) {
+        QueueTrace_record(this, done);
+    }
+    return waiter.element;
+}
+
+/*
+ * Handoff-mode offer: gives element to the longest-waiting consumer if there is one, else stores it.
+ * Must be called with the mutex held, which is released on success and kept when the queue is full.
+ * Returns false if the element could not be placed without waiting.
+ */
+static bool offerHandoff(BlockingQueue* this, void* element) {
+    BlockingQueueWaiter *consumer = takeWaiter(&(this->consumers), &(this->consumersTail));
+    if (consumer != NULL) {
+        pthread_mutex_unlock(&(this->mutex));
+        consumer->element = element;
+        if (QueueTrace_enabled()) {
+            QueueTrace_record(this, QUEUE_TRACE_ENQ);
+        }
+        sem_post(&(consumer->ready));
+        return true;
+    }
+    if (this->size < this->maxSize) {
+        pushTail(this, element);
+        pthread_mutex_unlock(&(this->mutex));
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Handoff-mode enq: offers element, parking until a consumer takes it if the queue is full.
+ */
+static void enqHandoff(BlockingQueue* this, void* element) {
+    pthread_mutex_lock(&(this->mutex));
+    if (!offerHandoff(this, element)) {
+        park(this, &(this->producers), &(this->producersTail), element, QUEUE_TRACE_BLOCK_ENQ, QUEUE_TRACE_ENQ);
+    }
+}
+
+/*
+ * Handoff-mode deq: takes the head element, refilling its slot from the longest-waiting producer,
+ * or takes a parked producer's element directly when the queue has no capacity. If block is
+ * false, returns NULL instead of parking on an empty queue.
+ */
+static void* deqHandoff(BlockingQueue* this, bool block) {
+    pthread_mutex_lock(&(this->mutex));
+    BlockingQueueWaiter *producer = takeWaiter(&(this->producers), &(this->producersTail));
+    void *data;
+    if (this->size > 0) {
+        data = takeHead(this);
+        if (producer != NULL) {
+            storeTail(this, producer->element);
+        }
+    } else if (producer != NULL) {
+        data = producer->element;
+        if (QueueTrace_enabled()) {
+            QueueTrace_record(this, QUEUE_TRACE_DEQ);
+        }
+    } else if (block) {
+        return park(this, &(this->consumers), &(this->consumersTail), NULL, QUEUE_TRACE_BLOCK_DEQ, QUEUE_TRACE_DEQ);
+    } else {
+        pthread_mutex_unlock(&(this->mutex));
+        return NULL;
+    }
+    pthread_mutex_unlock(&(this->mutex));
+
+    if (producer != NULL) {
+        sem_post(&(producer->ready));
+    }
+    return data;
+}
+
+/*
+ * Enqueues element on a full queue according to a non-blocking overflow policy.
+ * Each attempt is constant time. An attempt only fails when every element is claimed by a
+ * consumer that has not removed it yet, so the caller yields to let it finish before retrying.
+ */
+static bool enqOverflow(BlockingQueue* this, void* element) {
+    for (;;) {
+        if (sem_trywait(&(this->empty)) == 0) {
+            pthread_mutex_lock(&(this->mutex));
+            pushTail(this, element);
+            pthread_mutex_unlock(&(this->mutex));
+            sem_post(&(this->full));
+            return true;
+        }
+
+        if (this->policy == BLOCKING_QUEUE_REJECT) {
+            atomic_fetch_add_explicit(&(this->rejected), 1, memory_order_relaxed);
+            return false;
+        }
+
+        /* Claim the oldest element so no consumer can take it, then replace it with the new one. */
+        if (sem_trywait(&(this->full)) == 0) {
+            pthread_mutex_lock(&(this->mutex));
+            void* evicted = popHead(this);
+            pushTail(this, element);
+            pthread_mutex_unlock(&(this->mutex));
+            sem_post(&(this->full));
+
+            atomic_fetch_add_explicit(&(this->dropped), 1, memory_order_relaxed);
+            if (this->policy == BLOCKING_QUEUE_DROP_OLDEST && this->onDrop != NULL) {
+                this->onDrop(evicted);
+            }
+            return true;
+        }
+
+        sched_yield();
+    }
+}
+
 bool BlockingQueue_enq(BlockingQueue* this, void* element) {
     if (element == NULL) {
         return false;
     }
 
-    sem_wait(&(this->empty));
+    if (this->handoff) {
+        enqHandoff(this, element);
+        return true;
+    }
+
+    if (this->policy != BLOCKING_QUEUE_BLOCK) {
+        return enqOverflow(this, element);
+    }
+
+    waitFor(this, &(this->empty), QUEUE_TRACE_BLOCK_ENQ);
     pthread_mutex_lock(&(this->mutex));
 
-    this->array[this->size] = element;
-    this->size++;
+    pushTail(this, element);
 
     pthread_mutex_unlock(&(this->mutex));
     sem_post(&(this->full));
@@ -58,16 +335,155 @@ bool BlockingQueue_enq(BlockingQueue* this, void* element) {
     return true;
 }
 
+size_t BlockingQueue_enqBatch(BlockingQueue* this, void** elements, size_t count) {
+    size_t enqueued = 0;
+    if (this->handoff || this->policy != BLOCKING_QUEUE_BLOCK) {
+        for (size_t i = 0; i < count; i++) {
+            enqueued += BlockingQueue_enq(this, elements[i]) ? 1 : 0;
+        }
+        return enqueued;
+    }
+
+    size_t next = 0;
+    while (next < count) {
+        if (elements[next] == NULL) {
+            next++;
+            continue;
+        }
+
+        /* Wait for one free slot, then claim as many more as are free without blocking. */
+        waitFor(this, &(this->empty), QUEUE_TRACE_BLOCK_ENQ);
+        size_t claimed = 1;
+        size_t end = next + 1;
+        while (end < count && (elements[end] == NULL || sem_trywait(&(this->empty)) == 0)) {
+            claimed += elements[end] != NULL ? 1 : 0;
+            end++;
+        }
+
+        pthread_mutex_lock(&(this->mutex));
+        for (size_t i = next; i < end; i++) {
+            if (elements[i] != NULL) {
+                pushTail(this, elements[i]);
+            }
+        }
+        pthread_mutex_unlock(&(this->mutex));
+
+        for (size_t i = 0; i < claimed; i++) {
+            sem_post(&(this->full));
+        }
+        enqueued += claimed;
+        next = end;
+    }
+
+    return enqueued;
+}
+
+size_t BlockingQueue_tryEnqBatch(BlockingQueue* this, void** elements, size_t count) {
+    size_t end = 0;
+    if (this->handoff) {
+        while (end < count) {
+            if (elements[end] != NULL) {
+                pthread_mutex_lock(&(this->mutex));
+                if (!offerHandoff(this, elements[end])) {
+                    pthread_mutex_unlock(&(this->mutex));
+                    break;
+                }
+            }
+            end++;
+        }
+        return end;
+    }
+
+    if (this->policy != BLOCKING_QUEUE_BLOCK) {
+        BlockingQueue_enqBatch(this, elements, count);
+        return count;
+    }
+
+    size_t claimed = 0;
+    while (end < count && (elements[end] == NULL || sem_trywait(&(this->empty)) == 0)) {
+        claimed += elements[end] != NULL ? 1 : 0;
+        end++;
+    }
+    if (claimed == 0) {
+        return end;
+    }
+
+    pthread_mutex_lock(&(this->mutex));
+    for (size_t i = 0; i < end; i++) {
+        if (elements[i] != NULL) {
+            pushTail(this, elements[i]);
+        }
+    }
+    pthread_mutex_unlock(&(this->mutex));
+
+    for (size_t i = 0; i < claimed; i++) {
+        sem_post(&(this->full));
+    }
+    return end;
+}
+
 void* BlockingQueue_deq(BlockingQueue* this) {
+    if (this->handoff) {
+        return deqHandoff(this, true);
+    }
+
     void* data = NULL;
-    sem_wait(&(this->full));
+    waitFor(this, &(this->full), QUEUE_TRACE_BLOCK_DEQ);
     pthread_mutex_lock(&(this->mutex));
 
-    data = this->array[0];
-    for (int i = 1; i < this->size; i++) {
-        this->array[i - 1] = this->array[i];
+    data = takeHead(this);
+
+    pthread_mutex_unlock(&(this->mutex));
+    sem_post(&(this->empty));
+
+    return data;
+}
+
+size_t BlockingQueue_deqBatch(BlockingQueue* this, void** elements, size_t max_count) {
+    if (max_count == 0) {
+        return 0;
+    }
+
+    if (this->handoff) {
+        elements[0] = deqHandoff(this, true);
+        size_t taken = 1;
+        while (taken < max_count && (elements[taken] = deqHandoff(this, false)) != NULL) {
+            taken++;
+        }
+        return taken;
     }
-    this->size--;
+
+    /* Wait for one element, then claim as many more as are available without blocking. */
+    waitFor(this, &(this->full), QUEUE_TRACE_BLOCK_DEQ);
+    size_t claimed = 1;
+    while (claimed < max_count && sem_trywait(&(this->full)) == 0) {
+        claimed++;
+    }
+
+    pthread_mutex_lock(&(this->mutex));
+    for (size_t i = 0; i < claimed; i++) {
+        elements[i] = takeHead(this);
+    }
+    pthread_mutex_unlock(&(this->mutex));
+
+    for (size_t i = 0; i < claimed; i++) {
+        sem_post(&(this->empty));
+    }
+
+    return claimed;
+}
+
+void* BlockingQueue_tryDeq(BlockingQueue* this) {
+    if (this->handoff) {
+        return deqHandoff(this, false);
+    }
+
+    if (sem_trywait(&(this->full)) != 0) {
+        return NULL;
+    }
+    pthread_mutex_lock(&(this->mutex));
+
+    void* data = takeHead(this);
 
     pthread_mutex_unlock(&(this->mutex));
     sem_post(&(this->empty));
@@ -75,9 +491,9 @@ void* BlockingQueue_deq(BlockingQueue* this) {
     return data;
 }
 
-int BlockingQueue_size(BlockingQueue* this) {
+size_t BlockingQueue_size(BlockingQueue* this) {
     pthread_mutex_lock(&(this->mutex));
-    int size = this->size;
+    size_t size = this->size;
     pthread_mutex_unlock(&(this->mutex));
     return size;
 }
@@ -89,14 +505,47 @@ bool BlockingQueue_isEmpty(BlockingQueue* this) {
     return empty;
 }
 
+long BlockingQueue_rejected(BlockingQueue* this) {
+    return atomic_load_explicit(&(this->rejected), memory_order_relaxed);
+}
+
+long BlockingQueue_dropped(BlockingQueue* this) {
+    return atomic_load_explicit(&(this->dropped), memory_order_relaxed);
+}
+
 void BlockingQueue_clear(BlockingQueue* this) {
     pthread_mutex_lock(&(this->mutex));
-    this->size = 0;
+    if (this->handoff) {
+        /* Parked producers' elements are not yet in the queue; they fill the freed slots. */
+        while (this->size > 0) {
+            popHead(this);
+        }
+        BlockingQueueWaiter *producer;
+        while (this->size < this->maxSize
+                && (producer = takeWaiter(&(this->producers), &(this->producersTail))) != NULL) {
+            storeTail(this, producer->element);
+            sem_post(&(producer->ready));
+        }
+        pthread_mutex_unlock(&(this->mutex));
+        return;
+    }
+    /* Only remove elements no consumer has claimed yet, keeping the semaphores in step with size. */
+    while (sem_trywait(&(this->full)) == 0) {
+        popHead(this);
+        sem_post(&(this->empty));
+    }
+    if (this->reserved && this->size == 0) {
+        ReservedRing_releaseAll(this->array, this->maxSize);
+    }
     pthread_mutex_unlock(&(this->mutex));
 }
 
 void BlockingQueue_destroy(BlockingQueue* this) {
-    free(this->array);
+    if (this->reserved) {
+        ReservedRing_free(this->array, this->maxSize);
+    } else {
+        free(this->array);
+    }
     pthread_mutex_destroy(&(this->mutex));
     sem_destroy(&(this->full));
     sem_destroy(&(this->empty));
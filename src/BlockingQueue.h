@@ -10,62 +10,187 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#ifndef __cplusplus
+#include <stdatomic.h>
+#endif
 #include <pthread.h>
 #include <semaphore.h>
 #include <stdlib.h>
+#include <limits.h>
 
 #include "Queue.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef struct BlockingQueue BlockingQueue;
 
+/*
+ * What BlockingQueue_enq does when the queue is full.
+ */
+typedef enum BlockingQueuePolicy {
+    /* Block the producer until there is space (the default). */
+    BLOCKING_QUEUE_BLOCK,
+    /* Drop the new element: enq returns false and the rejected counter is incremented. */
+    BLOCKING_QUEUE_REJECT,
+    /* Evict the oldest element, passing it to the drop callback, and enqueue the new one. */
+    BLOCKING_QUEUE_DROP_OLDEST,
+    /* Ring mode: overwrite the oldest element without a callback, for elements the queue does not own. */
+    BLOCKING_QUEUE_OVERWRITE
+} BlockingQueuePolicy;
+
+/*
+ * A thread parked in a handoff queue, living on its own stack while it waits.
+ * Whoever completes its operation sets element, unlinks it and posts ready.
+ */
+typedef struct BlockingQueueWaiter {
+    struct BlockingQueueWaiter *next;
+    /* The element a producer offers, or the element handed to a consumer. */
+    void *element;
+    sem_t ready;
+} BlockingQueueWaiter;
+
 /* You should define your struct BlockingQueue here */
+/* C++ code only handles a BlockingQueue through pointers, so the struct is opaque to it. */
+#ifndef __cplusplus
 struct BlockingQueue {
     void **array;
-    int maxSize;
-    int size;
+    size_t maxSize;
+    size_t size;
+    size_t head;
+    bool reserved;
     pthread_mutex_t mutex;
     sem_t full;
     sem_t empty;
+    BlockingQueuePolicy policy;
+    void (*onDrop)(void *element);
+    atomic_long rejected;
+    atomic_long dropped;
+    /* Handoff mode: parked threads in arrival order, protected by mutex instead of the semaphores. */
+    bool handoff;
+    BlockingQueueWaiter *consumers;
+    BlockingQueueWaiter *consumersTail;
+    BlockingQueueWaiter *producers;
+    BlockingQueueWaiter *producersTail;
 };
+#endif
 
 /*
  * Creates a new BlockingQueue for at most max_size void* elements.
  * Returns a pointer to a new BlockingQueue on success and NULL on failure.
  */
-BlockingQueue* new_BlockingQueue(int max_size);
+BlockingQueue* new_BlockingQueue(size_t max_size);
+
+/*
+ * Creates a new BlockingQueue for at most max_size void* elements with the given overflow policy.
+ * max_size must be at least 1 for any policy other than BLOCKING_QUEUE_BLOCK.
+ * on_drop may be NULL; otherwise it is called outside the lock with each element evicted by
+ * BLOCKING_QUEUE_DROP_OLDEST so the caller can release it.
+ * Returns a pointer to a new BlockingQueue on success and NULL on failure.
+ */
+BlockingQueue* new_BlockingQueueWithPolicy(size_t max_size, BlockingQueuePolicy policy, void (*on_drop)(void *element));
+
+/*
+ * Creates a new BlockingQueue like new_BlockingQueueWithPolicy whose storage is reserved
+ * address space, committed only as occupancy reaches it and released as it drains.
+ * max_size may be at most SEM_VALUE_MAX, since the free and used slots are counted by semaphores.
+ * Returns a pointer to a new BlockingQueue on success and NULL on failure.
+ */
+BlockingQueue* new_BlockingQueueReserved(size_t max_size, BlockingQueuePolicy policy, void (*on_drop)(void *element));
+
+/*
+ * Creates a new BlockingQueue for at most max_size void* elements in handoff mode.
+ * An enq that finds a consumer parked on the empty queue passes the element straight to that
+ * consumer and wakes only it, so the consumer returns without taking the lock again; likewise
+ * a deq on a full queue takes over a parked producer's element. max_size may be 0, giving a
+ * synchronous queue in which every enq waits for a deq to take its element.
+ * Returns a pointer to a new BlockingQueue on success and NULL on failure.
+ */
+BlockingQueue* new_BlockingQueueHandoff(size_t max_size);
+
+/*
+ * Creates a new zero-capacity synchronous BlockingQueue, the same as new_BlockingQueueHandoff(0).
+ * Returns a pointer to a new BlockingQueue on success and NULL on failure.
+ */
+BlockingQueue* new_BlockingQueueSynchronous();
 
 /*
  * Enqueues the given void* element at the back of this Queue.
- * If the queue is full, the function will block the calling thread until there is space in the queue.
- * Returns false when element is NULL and true on success.
+ * If the queue is full, the function will block the calling thread until there is space in the queue,
+ * unless the queue was created with another overflow policy, in which case it returns immediately.
+ * Returns false when element is NULL or rejected by BLOCKING_QUEUE_REJECT, and true on success.
+ */
+bool BlockingQueue_enq(BlockingQueue* queue, void* element);
+
+/*
+ * Enqueues count void* elements at the back of this Queue in order, taking the lock once.
+ * Blocks like BlockingQueue_enq while there is not enough space, and applies the overflow
+ * policy to each element when the queue was created with one.
+ * Returns the number of elements enqueued; NULL elements are skipped.
  */
-bool BlockingQueue_enq(BlockingQueue* this, void* element);
+size_t BlockingQueue_enqBatch(BlockingQueue* queue, void** elements, size_t count);
+
+/*
+ * Enqueues the leading elements of elements in order without blocking, stopping at the first
+ * one that does not fit. NULL elements are skipped, and a queue created with an overflow
+ * policy applies it to every element instead of stopping.
+ * Returns how many leading entries of elements were consumed, counting skipped NULL elements.
+ */
+size_t BlockingQueue_tryEnqBatch(BlockingQueue* queue, void** elements, size_t count);
 
 /*
  * Dequeues an element from the front of this Queue.
  * If the queue is empty, the function will block until an element can be dequeued.
  * Returns the dequeued void* element.
  */
-void* BlockingQueue_deq(BlockingQueue* this);
+void* BlockingQueue_deq(BlockingQueue* queue);
+
+/*
+ * Dequeues up to max_count elements from the front of this Queue into elements, taking the lock once.
+ * If the queue is empty, the function will block until at least one element can be dequeued.
+ * Returns the number of elements dequeued, which is 0 only when max_count is 0.
+ */
+size_t BlockingQueue_deqBatch(BlockingQueue* queue, void** elements, size_t max_count);
+
+/*
+ * Dequeues an element from the front of this Queue without blocking.
+ * Returns the dequeued void* element or NULL if the queue is empty.
+ */
+void* BlockingQueue_tryDeq(BlockingQueue* queue);
 
 /*
  * Returns the number of elements currently in this Queue.
  */
-int BlockingQueue_size(BlockingQueue* this);
+size_t BlockingQueue_size(BlockingQueue* queue);
 
 /*
  * Returns true if this Queue is empty, false otherwise.
  */
-bool BlockingQueue_isEmpty(BlockingQueue* this);
+bool BlockingQueue_isEmpty(BlockingQueue* queue);
+
+/*
+ * Returns the number of elements rejected by BLOCKING_QUEUE_REJECT since creation.
+ */
+long BlockingQueue_rejected(BlockingQueue* queue);
+
+/*
+ * Returns the number of elements evicted by BLOCKING_QUEUE_DROP_OLDEST or BLOCKING_QUEUE_OVERWRITE since creation.
+ */
+long BlockingQueue_dropped(BlockingQueue* queue);
 
 /*
  * Clears this Queue returning it to an empty state.
  */
-void BlockingQueue_clear(BlockingQueue* this);
+void BlockingQueue_clear(BlockingQueue* queue);
 
 /*
  * Destroys this Queue by freeing the memory used by the Queue.
  */
-void BlockingQueue_destroy(BlockingQueue* this);
+void BlockingQueue_destroy(BlockingQueue* queue);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* BLOCKING_QUEUE_H_ */
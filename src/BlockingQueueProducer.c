@@ -0,0 +1,296 @@
+/*
+ * BlockingQueueProducer.c
+ *
+ * Batched producer handles with a shared background flusher bounding staging latency.
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "BlockingQueueProducer.h"
+
+/*
+ * Shortest time the flusher waits before looking again at a handle it could not fully publish.
+ */
+#define FLUSH_RETRY_NS 100000u
+
+/*
+ * Handles with a timed flush, served by one flusher thread that runs while any exist.
+ * wakeNs is when the waiting flusher will next wake: UINT64_MAX while nothing is staged,
+ * and 0 while it is not waiting.
+ */
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    pthread_cond_t unpinned;
+    BlockingQueueProducer *head;
+    uint64_t wakeNs;
+    bool running;
+} registry = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, 0, false };
+
+/*
+ * Guards the one-time switch of the registry's condition variable to the monotonic clock.
+ */
+static pthread_once_t registryOnce = PTHREAD_ONCE_INIT;
+
+/*
+ * Re-initialises the registry's condition variable so timed waits use the monotonic clock.
+ */
+static void initRegistry() {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_destroy(&(registry.changed));
+    pthread_cond_init(&(registry.changed), &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/*
+ * Returns the current monotonic time in nanoseconds.
+ */
+static uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+/*
+ * Publishes the staged elements. Must be called with the handle's mutex held.
+ */
+static void publish(BlockingQueueProducer* this) {
+    if (this->size > 0) {
+        BlockingQueue_enqBatch(this->queue, this->buffer, this->size);
+        this->size = 0;
+    }
+}
+
+/*
+ * Schedules the flusher to look at a handle by due, waking it if it would sleep past that.
+ * A due of 0 schedules nothing. Must be called with the registry mutex held.
+ */
+static void schedule(BlockingQueueProducer* this, uint64_t due) {
+    if (due != 0 && (this->dueNs == 0 || due < this->dueNs)) {
+        this->dueNs = due;
+        if (due < registry.wakeNs) {
+            pthread_cond_signal(&(registry.changed));
+        }
+    }
+}
+
+/*
+ * Publishes as much of an overdue batch as fits in the queue without blocking.
+ * Returns when the flusher should look at the handle again, or 0 once nothing is staged.
+ */
+static uint64_t publishOverdue(BlockingQueueProducer* this, uint64_t now) {
+    uint64_t retry = now + (this->maxDelayNs > FLUSH_RETRY_NS ? this->maxDelayNs : FLUSH_RETRY_NS);
+    if (pthread_mutex_trylock(&(this->mutex)) != 0) {
+        /* The producer is staging or publishing itself, possibly blocked on a full queue. */
+        return retry;
+    }
+
+    uint64_t due = 0;
+    if (this->size > 0) {
+        due = this->firstStagedNs + this->maxDelayNs;
+        if (now >= due) {
+            size_t published = BlockingQueue_tryEnqBatch(this->queue, this->buffer, this->size);
+            this->size -= published;
+            memmove(this->buffer, this->buffer + published, sizeof(void*) * this->size);
+            due = this->size > 0 ? retry : 0;
+        }
+    }
+    pthread_mutex_unlock(&(this->mutex));
+    return due;
+}
+
+/*
+ * Flusher thread: sleeps until the earliest scheduled handle is due, or indefinitely while
+ * nothing is staged. Overdue handles are pinned and published without the registry mutex,
+ * so neither registration nor other handles wait on a full queue.
+ * Exits once no handles are registered.
+ */
+static void *flusher(void *arg) {
+    (void) arg;
+    pthread_mutex_lock(&(registry.mutex));
+    while (registry.head != NULL) {
+        uint64_t now = nowNs();
+        uint64_t next = UINT64_MAX;
+        BlockingQueueProducer *overdue = NULL;
+        for (BlockingQueueProducer *p = registry.head; p != NULL; p = p->nextRegistered) {
+            if (p->dueNs != 0 && p->dueNs <= now) {
+                p->dueNs = 0;
+                p->pins++;
+                p->nextOverdue = overdue;
+                overdue = p;
+            } else if (p->dueNs != 0 && p->dueNs < next) {
+                next = p->dueNs;
+            }
+        }
+
+        if (overdue != NULL) {
+            pthread_mutex_unlock(&(registry.mutex));
+            while (overdue != NULL) {
+                BlockingQueueProducer *p = overdue;
+                uint64_t due = publishOverdue(p, now);
+                pthread_mutex_lock(&(registry.mutex));
+                overdue = p->nextOverdue;
+                schedule(p, due);
+                if (--p->pins == 0) {
+                    pthread_cond_broadcast(&(registry.unpinned));
+                }
+                pthread_mutex_unlock(&(registry.mutex));
+            }
+            pthread_mutex_lock(&(registry.mutex));
+            continue;
+        }
+
+        registry.wakeNs = next;
+        if (next == UINT64_MAX) {
+            pthread_cond_wait(&(registry.changed), &(registry.mutex));
+        } else {
+            struct timespec ts = { (time_t) (next / 1000000000u), (long) (next % 1000000000u) };
+            pthread_cond_timedwait(&(registry.changed), &(registry.mutex), &ts);
+        }
+        registry.wakeNs = 0;
+    }
+    registry.running = false;
+    pthread_mutex_unlock(&(registry.mutex));
+    return NULL;
+}
+
+/*
+ * Adds a handle to the registry, starting the flusher thread if it is not running.
+ * Returns false if the flusher thread could not be started.
+ */
+static bool registerProducer(BlockingQueueProducer* this) {
+    bool ok = true;
+    pthread_once(&registryOnce, initRegistry);
+    pthread_mutex_lock(&(registry.mutex));
+    this->nextRegistered = registry.head;
+    registry.head = this;
+    if (!registry.running) {
+        pthread_t thread;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&thread, &attr, flusher, NULL) == 0) {
+            registry.running = true;
+        } else {
+            registry.head = this->nextRegistered;
+            ok = false;
+        }
+        pthread_attr_destroy(&attr);
+    }
+    pthread_mutex_unlock(&(registry.mutex));
+    return ok;
+}
+
+/*
+ * Removes a handle from the registry and waits until the flusher no longer touches it.
+ */
+static void unregisterProducer(BlockingQueueProducer* this) {
+    pthread_mutex_lock(&(registry.mutex));
+    for (BlockingQueueProducer **p = &(registry.head); *p != NULL; p = &((*p)->nextRegistered)) {
+        if (*p == this) {
+            *p = this->nextRegistered;
+            break;
+        }
+    }
+    pthread_cond_signal(&(registry.changed));
+    while (this->pins > 0) {
+        pthread_cond_wait(&(registry.unpinned), &(registry.mutex));
+    }
+    pthread_mutex_unlock(&(registry.mutex));
+}
+
+BlockingQueueProducer *new_BlockingQueueProducer(BlockingQueue* queue, size_t batch_size, uint64_t max_delay_us) {
+    if (queue == NULL || batch_size == 0) {
+        return NULL;
+    }
+
+    BlockingQueueProducer* producer = (BlockingQueueProducer*) malloc(sizeof(BlockingQueueProducer));
+    if (producer == NULL) {
+        return NULL;
+    }
+
+    producer->buffer = (void**) malloc(sizeof(void*) * batch_size);
+    if (producer->buffer == NULL) {
+        free(producer);
+        return NULL;
+    }
+
+    producer->queue = queue;
+    producer->maxSize = batch_size;
+    producer->size = 0;
+    producer->maxDelayNs = max_delay_us * 1000u;
+    producer->firstStagedNs = 0;
+    producer->nextRegistered = NULL;
+    producer->dueNs = 0;
+    producer->pins = 0;
+    producer->nextOverdue = NULL;
+    pthread_mutex_init(&(producer->mutex), NULL);
+
+    if (max_delay_us > 0 && !registerProducer(producer)) {
+        pthread_mutex_destroy(&(producer->mutex));
+        free(producer->buffer);
+        free(producer);
+        return NULL;
+    }
+
+    return producer;
+}
+
+bool BlockingQueueProducer_enq(BlockingQueueProducer* this, void* element) {
+    if (element == NULL) {
+        return false;
+    }
+
+    pthread_mutex_lock(&(this->mutex));
+    bool first = this->size == 0 && this->maxDelayNs > 0;
+    if (first) {
+        this->firstStagedNs = nowNs();
+    }
+    this->buffer[this->size++] = element;
+    if (this->size == this->maxSize) {
+        publish(this);
+    }
+    bool staged = first && this->size > 0;
+    uint64_t due = this->firstStagedNs + this->maxDelayNs;
+    pthread_mutex_unlock(&(this->mutex));
+
+    /* The flusher sleeps until a handle stages its first element. */
+    if (staged) {
+        pthread_mutex_lock(&(registry.mutex));
+        schedule(this, due);
+        pthread_mutex_unlock(&(registry.mutex));
+    }
+
+    return true;
+}
+
+void BlockingQueueProducer_flush(BlockingQueueProducer* this) {
+    pthread_mutex_lock(&(this->mutex));
+    publish(this);
+    pthread_mutex_unlock(&(this->mutex));
+}
+
+size_t BlockingQueueProducer_pending(BlockingQueueProducer* this) {
+    pthread_mutex_lock(&(this->mutex));
+    size_t pending = this->size;
+    pthread_mutex_unlock(&(this->mutex));
+    return pending;
+}
+
+void BlockingQueueProducer_destroy(BlockingQueueProducer* this) {
+    if (this->maxDelayNs > 0) {
+        unregisterProducer(this);
+    }
+    BlockingQueueProducer_flush(this);
+    pthread_mutex_destroy(&(this->mutex));
+    free(this->buffer);
+    free(this);
+}
@@ -0,0 +1,77 @@
+/*
+ * BlockingQueueProducer.h
+ *
+ * Module interface for a buffered producer handle over a BlockingQueue.
+ *
+ * A producer thread stages elements in its own handle and publishes them to the shared
+ * queue with one BlockingQueue_enqBatch call, so the queue's lock is taken once per batch
+ * instead of once per element. A batch is published when the buffer is full, on
+ * BlockingQueueProducer_flush, or once its oldest element has waited max_delay_us, which
+ * a shared background flusher thread enforces even if the producer goes idle.
+ * The flusher never blocks on a full queue: it publishes what fits and retries the rest later.
+ * Each handle publishes its elements in the order they were staged.
+ *
+ */
+
+#ifndef BLOCKING_QUEUE_PRODUCER_H_
+#define BLOCKING_QUEUE_PRODUCER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "BlockingQueue.h"
+
+typedef struct BlockingQueueProducer BlockingQueueProducer;
+
+struct BlockingQueueProducer {
+    BlockingQueue *queue;
+    void **buffer;
+    size_t maxSize;
+    size_t size;
+    uint64_t maxDelayNs;
+    uint64_t firstStagedNs;
+    /* Only contended when the flusher thread publishes an overdue batch. */
+    pthread_mutex_t mutex;
+    BlockingQueueProducer *nextRegistered;
+    /* The remaining fields are guarded by the registry mutex in BlockingQueueProducer.c. */
+    /* When the flusher next publishes this handle, or 0 if nothing is staged. */
+    uint64_t dueNs;
+    /* Flusher passes using the handle outside the registry mutex; destroy waits for none. */
+    int pins;
+    BlockingQueueProducer *nextOverdue;
+};
+
+/*
+ * Creates a new producer handle staging up to batch_size elements for queue.
+ * If max_delay_us is positive, staged elements are published at most about max_delay_us
+ * microseconds after the first of them was staged; 0 disables the timed flush.
+ * A handle must only be used by one producer thread at a time.
+ * Returns a pointer to a new BlockingQueueProducer on success and NULL on failure.
+ */
+BlockingQueueProducer* new_BlockingQueueProducer(BlockingQueue* queue, size_t batch_size, uint64_t max_delay_us);
+
+/*
+ * Stages the given void* element, publishing the batch if the buffer is now full.
+ * Publishing blocks like BlockingQueue_enq while the queue is full.
+ * Returns false when element is NULL and true on success.
+ */
+bool BlockingQueueProducer_enq(BlockingQueueProducer* this, void* element);
+
+/*
+ * Publishes every staged element to the queue.
+ */
+void BlockingQueueProducer_flush(BlockingQueueProducer* this);
+
+/*
+ * Returns the number of elements staged but not yet published.
+ */
+size_t BlockingQueueProducer_pending(BlockingQueueProducer* this);
+
+/*
+ * Flushes and destroys this handle. The queue itself is not destroyed.
+ */
+void BlockingQueueProducer_destroy(BlockingQueueProducer* this);
+
+#endif /* BLOCKING_QUEUE_PRODUCER_H_ */
@@ -0,0 +1,202 @@
+/*
+ * BroadcastRing.c
+ *
+ * Disruptor-style single-publisher multicast ring with per-consumer sequence cursors.
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "BroadcastRing.h"
+
+/*
+ * Number of times a waiting thread yields before parking on the condition variable.
+ */
+#define SPIN_LIMIT 100
+
+/*
+ * Returns the smallest cursor among the given consumers, or limit if it is smaller.
+ */
+static int64_t minCursor(BroadcastConsumer* consumers, int count, int64_t limit) {
+    for (int i = 0; i < count; i++) {
+        int64_t cursor = atomic_load_explicit(&(consumers[i].cursor), memory_order_acquire);
+        limit = cursor < limit ? cursor : limit;
+    }
+    return limit;
+}
+
+/*
+ * Returns the highest sequence the given consumer may read: published and committed by every dependency.
+ */
+static int64_t availableTo(BroadcastConsumer* this) {
+    int64_t limit = atomic_load_explicit(&(this->ring->published), memory_order_acquire);
+    for (int i = 0; i < this->numDependencies; i++) {
+        int64_t cursor = atomic_load_explicit(&(this->dependencies[i]->cursor), memory_order_acquire);
+        limit = cursor < limit ? cursor : limit;
+    }
+    return limit;
+}
+
+/*
+ * Wakes every parked thread after a cursor has moved.
+ */
+static void signalMoved(BroadcastRing* this) {
+    if (atomic_load(&(this->waiters)) > 0) {
+        pthread_mutex_lock(&(this->mutex));
+        pthread_cond_broadcast(&(this->moved));
+        pthread_mutex_unlock(&(this->mutex));
+    }
+}
+
+/*
+ * Parks the calling thread until another thread moves a cursor.
+ * ready is re-checked under the mutex so a wake-up cannot be missed.
+ */
+static void park(BroadcastRing* this, bool (*ready)(void *), void *arg) {
+    pthread_mutex_lock(&(this->mutex));
+    atomic_fetch_add(&(this->waiters), 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    while (!ready(arg)) {
+        pthread_cond_wait(&(this->moved), &(this->mutex));
+    }
+    atomic_fetch_sub(&(this->waiters), 1);
+    pthread_mutex_unlock(&(this->mutex));
+}
+
+/*
+ * Returns true once the publisher may write the next sequence.
+ */
+static bool publisherReady(void *arg) {
+    BroadcastRing *this = (BroadcastRing *) arg;
+    int64_t wrap = atomic_load_explicit(&(this->published), memory_order_relaxed) + 1 - (this->mask + 1);
+    this->gate = minCursor(this->consumers, this->numConsumers, INT64_MAX);
+    return this->gate >= wrap;
+}
+
+/*
+ * Returns true once the consumer's next sequence is available.
+ */
+static bool consumerReady(void *arg) {
+    BroadcastConsumer *this = (BroadcastConsumer *) arg;
+    int64_t next = atomic_load_explicit(&(this->cursor), memory_order_relaxed) + 1;
+    this->available = availableTo(this);
+    return this->available >= next;
+}
+
+/*
+ * Yields a bounded number of times until ready holds, then parks.
+ */
+static void waitUntil(BroadcastRing* this, bool (*ready)(void *), void *arg) {
+    for (int i = 0; i < SPIN_LIMIT; i++) {
+        if (ready(arg)) {
+            return;
+        }
+        sched_yield();
+    }
+    park(this, ready, arg);
+}
+
+BroadcastRing *new_BroadcastRing(int capacity) {
+    if (capacity <= 0) {
+        return NULL;
+    }
+
+    BroadcastRing* ring = (BroadcastRing*) aligned_alloc(BROADCAST_RING_CACHE_LINE, sizeof(BroadcastRing));
+    if (ring == NULL) {
+        return NULL;
+    }
+
+    int64_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    ring->array = (void**) malloc(sizeof(void*) * size);
+    ring->consumers = (BroadcastConsumer*) aligned_alloc(BROADCAST_RING_CACHE_LINE,
+            sizeof(BroadcastConsumer) * BROADCAST_RING_MAX_CONSUMERS);
+    if (ring->array == NULL || ring->consumers == NULL) {
+        free(ring->array);
+        free(ring->consumers);
+        free(ring);
+        return NULL;
+    }
+
+    ring->mask = size - 1;
+    ring->numConsumers = 0;
+    atomic_init(&(ring->published), -1);
+    ring->gate = -1;
+    atomic_init(&(ring->waiters), 0);
+    pthread_mutex_init(&(ring->mutex), NULL);
+    pthread_cond_init(&(ring->moved), NULL);
+
+    return ring;
+}
+
+BroadcastConsumer *BroadcastRing_addConsumer(BroadcastRing* this, BroadcastConsumer** dependencies, int num_dependencies) {
+    if (this->numConsumers == BROADCAST_RING_MAX_CONSUMERS || num_dependencies < 0
+            || num_dependencies > BROADCAST_RING_MAX_DEPENDENCIES) {
+        return NULL;
+    }
+
+    BroadcastConsumer *consumer = &(this->consumers[this->numConsumers]);
+    int64_t start = atomic_load(&(this->published));
+    atomic_init(&(consumer->cursor), start);
+    consumer->available = start;
+    consumer->ring = this;
+    consumer->numDependencies = num_dependencies;
+    for (int i = 0; i < num_dependencies; i++) {
+        consumer->dependencies[i] = dependencies[i];
+    }
+    this->numConsumers++;
+
+    return consumer;
+}
+
+bool BroadcastRing_publish(BroadcastRing* this, void* element) {
+    if (element == NULL) {
+        return false;
+    }
+
+    int64_t next = atomic_load_explicit(&(this->published), memory_order_relaxed) + 1;
+    if (this->gate < next - (this->mask + 1)) {
+        waitUntil(this, publisherReady, this);
+    }
+
+    this->array[next & this->mask] = element;
+    atomic_store_explicit(&(this->published), next, memory_order_seq_cst);
+    signalMoved(this);
+
+    return true;
+}
+
+void* BroadcastConsumer_wait(BroadcastConsumer* this) {
+    int64_t next = atomic_load_explicit(&(this->cursor), memory_order_relaxed) + 1;
+    if (this->available < next) {
+        waitUntil(this->ring, consumerReady, this);
+    }
+    return this->ring->array[next & this->ring->mask];
+}
+
+void BroadcastConsumer_commit(BroadcastConsumer* this) {
+    int64_t next = atomic_load_explicit(&(this->cursor), memory_order_relaxed) + 1;
+    atomic_store_explicit(&(this->cursor), next, memory_order_seq_cst);
+    signalMoved(this->ring);
+}
+
+int BroadcastConsumer_backlog(BroadcastConsumer* this) {
+    int64_t published = atomic_load(&(this->ring->published));
+    return (int) (published - atomic_load(&(this->cursor)));
+}
+
+void BroadcastRing_destroy(BroadcastRing* this) {
+    free(this->array);
+    free(this->consumers);
+    pthread_mutex_destroy(&(this->mutex));
+    pthread_cond_destroy(&(this->moved));
+    free(this);
+}
@@ -0,0 +1,99 @@
+/*
+ * BroadcastRing.h
+ *
+ * Module interface for a single-publisher multicast ring buffer.
+ *
+ * The publisher writes each void* element into the ring once, and every registered
+ * consumer reads it by advancing its own sequence cursor. The publisher is gated by the
+ * slowest consumer, so no element is overwritten before every consumer has committed it.
+ * A consumer may depend on other consumers, in which case it only sees an element after
+ * all of its dependencies have committed it, forming processing stages over one ring.
+ *
+ */
+
+#ifndef BROADCAST_RING_H_
+#define BROADCAST_RING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define BROADCAST_RING_MAX_CONSUMERS 32
+#define BROADCAST_RING_MAX_DEPENDENCIES 8
+#define BROADCAST_RING_CACHE_LINE 64
+
+typedef struct BroadcastRing BroadcastRing;
+typedef struct BroadcastConsumer BroadcastConsumer;
+
+struct BroadcastConsumer {
+    /* Sequence of the last element this consumer committed, written only by its own thread. */
+    _Alignas(BROADCAST_RING_CACHE_LINE) _Atomic int64_t cursor;
+    int64_t available;
+    BroadcastRing *ring;
+    BroadcastConsumer *dependencies[BROADCAST_RING_MAX_DEPENDENCIES];
+    int numDependencies;
+};
+
+struct BroadcastRing {
+    void **array;
+    int64_t mask;
+    int numConsumers;
+    BroadcastConsumer *consumers;
+
+    /* Publisher side: last published sequence and cached minimum consumer cursor. */
+    _Alignas(BROADCAST_RING_CACHE_LINE) _Atomic int64_t published;
+    int64_t gate;
+
+    /* Parking for threads that have waited too long for a cursor to move. */
+    _Alignas(BROADCAST_RING_CACHE_LINE) atomic_int waiters;
+    pthread_mutex_t mutex;
+    pthread_cond_t moved;
+};
+
+/*
+ * Creates a new BroadcastRing holding at least capacity elements, rounded up to a power of two.
+ * Returns a pointer to a new BroadcastRing on success and NULL on failure.
+ */
+BroadcastRing* new_BroadcastRing(int capacity);
+
+/*
+ * Registers a new consumer that only sees elements after every consumer in dependencies
+ * (num_dependencies of them, possibly 0) has committed them.
+ * Consumers must be added before the first element is published.
+ * Returns the new consumer on success and NULL when the consumer limit is reached.
+ */
+BroadcastConsumer* BroadcastRing_addConsumer(BroadcastRing* this, BroadcastConsumer** dependencies, int num_dependencies);
+
+/*
+ * Publishes the given void* element to every consumer. Must only be called from one thread.
+ * If the slowest consumer is a full ring behind, the function will block until it catches up.
+ * Returns false when element is NULL and true on success.
+ */
+bool BroadcastRing_publish(BroadcastRing* this, void* element);
+
+/*
+ * Waits for the next element this consumer has not yet committed.
+ * If it has not been published, or a dependency has not committed it yet, the function will block.
+ * Returns the element, which stays valid until BroadcastConsumer_commit.
+ */
+void* BroadcastConsumer_wait(BroadcastConsumer* this);
+
+/*
+ * Marks the element returned by the last BroadcastConsumer_wait as processed, releasing
+ * it to dependent consumers and, once all consumers are done, to the publisher.
+ */
+void BroadcastConsumer_commit(BroadcastConsumer* this);
+
+/*
+ * Returns the number of published elements the given consumer has not committed yet.
+ */
+int BroadcastConsumer_backlog(BroadcastConsumer* this);
+
+/*
+ * Destroys this ring and all of its consumers by freeing the memory used.
+ */
+void BroadcastRing_destroy(BroadcastRing* this);
+
+#endif /* BROADCAST_RING_H_ */
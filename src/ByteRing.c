@@ -0,0 +1,223 @@
+/*
+ * ByteRing.c
+ *
+ * Blocking ring of variable-length byte records with in-place reserve/commit and read/release.
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "ByteRing.h"
+
+/*
+ * Record states, stored in ByteRingRecord.state.
+ */
+enum {
+    /* Reserved by a producer that has not committed it yet. */
+    RECORD_RESERVED = 1,
+    /* Committed and waiting for a consumer. */
+    RECORD_COMMITTED,
+    /* Handed to a consumer that has not released it yet. */
+    RECORD_READING,
+    /* Released, reclaimed once every older record is. */
+    RECORD_RELEASED,
+    /* Fills the end of the buffer before a record that would not fit there. */
+    RECORD_PADDING
+};
+
+/*
+ * Rounds size up to a multiple of BYTE_RING_ALIGN.
+ */
+static size_t alignUp(size_t size) {
+    return (size + BYTE_RING_ALIGN - 1) & ~((size_t) BYTE_RING_ALIGN - 1);
+}
+
+/*
+ * Returns the header of the record at the given offset.
+ */
+static ByteRingRecord *recordAt(ByteRing* this, uint64_t offset) {
+    return (ByteRingRecord *) (this->buffer + offset % this->capacity);
+}
+
+/*
+ * Advances head past released records and padding that consumers have passed.
+ * Returns true if any space was freed. Must be called with the mutex held.
+ */
+static bool reclaim(ByteRing* this) {
+    uint64_t before = this->head;
+    while (this->head < this->readCursor) {
+        ByteRingRecord *record = recordAt(this, this->head);
+        if (record->state != RECORD_RELEASED && record->state != RECORD_PADDING) {
+            break;
+        }
+        this->head += record->span;
+    }
+    return this->head != before;
+}
+
+/*
+ * Hands the oldest record to the caller if it is committed, skipping padding.
+ * Returns its payload, or NULL if the next record is missing or uncommitted.
+ * Must be called with the mutex held.
+ */
+static const void *takeRecord(ByteRing* this, size_t* length) {
+    while (this->readCursor < this->tail) {
+        ByteRingRecord *record = recordAt(this, this->readCursor);
+        if (record->state == RECORD_PADDING) {
+            this->readCursor += record->span;
+            continue;
+        }
+        if (record->state != RECORD_COMMITTED) {
+            return NULL;
+        }
+        record->state = RECORD_READING;
+        this->readCursor += record->span;
+        *length = record->length;
+        return record + 1;
+    }
+    return NULL;
+}
+
+ByteRing *new_ByteRing(size_t capacity) {
+    if (capacity == 0 || capacity > (UINT32_MAX & ~((size_t) BYTE_RING_ALIGN - 1))) {
+        return NULL;
+    }
+
+    ByteRing* ring = (ByteRing*) malloc(sizeof(ByteRing));
+    if (ring == NULL) {
+        return NULL;
+    }
+
+    ring->capacity = alignUp(capacity);
+    ring->buffer = (unsigned char*) aligned_alloc(BYTE_RING_ALIGN, ring->capacity);
+    if (ring->buffer == NULL) {
+        free(ring);
+        return NULL;
+    }
+
+    ring->head = 0;
+    ring->readCursor = 0;
+    ring->tail = 0;
+    pthread_mutex_init(&(ring->mutex), NULL);
+    pthread_cond_init(&(ring->notFull), NULL);
+    pthread_cond_init(&(ring->notEmpty), NULL);
+
+    return ring;
+}
+
+void* ByteRing_reserve(ByteRing* this, size_t length) {
+    if (length > this->capacity) {
+        return NULL;
+    }
+    size_t span = sizeof(ByteRingRecord) + alignUp(length);
+    if (span > this->capacity) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&(this->mutex));
+    size_t toEnd;
+    for (;;) {
+        toEnd = this->capacity - this->tail % this->capacity;
+        if (span > toEnd && this->head == this->tail) {
+            /* Nothing is left in the ring, so restart at the beginning of the buffer without padding. */
+            this->tail += toEnd;
+            this->readCursor = this->tail;
+            this->head = this->tail;
+            toEnd = this->capacity;
+        }
+        size_t needed = span <= toEnd ? span : toEnd + span;
+        if (this->capacity - (this->tail - this->head) >= needed) {
+            break;
+        }
+        pthread_cond_wait(&(this->notFull), &(this->mutex));
+    }
+
+    if (span > toEnd) {
+        ByteRingRecord *padding = recordAt(this, this->tail);
+        padding->span = (uint32_t) toEnd;
+        padding->length = 0;
+        padding->state = RECORD_PADDING;
+        this->tail += toEnd;
+    }
+
+    ByteRingRecord *record = recordAt(this, this->tail);
+    record->span = (uint32_t) span;
+    record->length = (uint32_t) length;
+    record->state = RECORD_RESERVED;
+    this->tail += span;
+    pthread_mutex_unlock(&(this->mutex));
+
+    return record + 1;
+}
+
+void ByteRing_commit(ByteRing* this, void* data, size_t length) {
+    ByteRingRecord *record = (ByteRingRecord *) data - 1;
+
+    pthread_mutex_lock(&(this->mutex));
+    if (length < record->length) {
+        record->length = (uint32_t) length;
+    }
+    record->state = RECORD_COMMITTED;
+    pthread_cond_broadcast(&(this->notEmpty));
+    pthread_mutex_unlock(&(this->mutex));
+}
+
+const void* ByteRing_read(ByteRing* this, size_t* length) {
+    const void *data;
+
+    pthread_mutex_lock(&(this->mutex));
+    while ((data = takeRecord(this, length)) == NULL) {
+        pthread_cond_wait(&(this->notEmpty), &(this->mutex));
+    }
+    if (reclaim(this)) {
+        pthread_cond_broadcast(&(this->notFull));
+    }
+    pthread_mutex_unlock(&(this->mutex));
+
+    return data;
+}
+
+const void* ByteRing_tryRead(ByteRing* this, size_t* length) {
+    pthread_mutex_lock(&(this->mutex));
+    const void *data = takeRecord(this, length);
+    if (reclaim(this)) {
+        pthread_cond_broadcast(&(this->notFull));
+    }
+    pthread_mutex_unlock(&(this->mutex));
+
+    return data;
+}
+
+void ByteRing_release(ByteRing* this, const void* data) {
+    ByteRingRecord *record = (ByteRingRecord *) data - 1;
+
+    pthread_mutex_lock(&(this->mutex));
+    record->state = RECORD_RELEASED;
+    if (reclaim(this)) {
+        pthread_cond_broadcast(&(this->notFull));
+    }
+    pthread_mutex_unlock(&(this->mutex));
+}
+
+size_t ByteRing_usedBytes(ByteRing* this) {
+    pthread_mutex_lock(&(this->mutex));
+    size_t used = (size_t) (this->tail - this->head);
+    pthread_mutex_unlock(&(this->mutex));
+
+    return used;
+}
+
+size_t ByteRing_capacity(ByteRing* this) {
+    return this->capacity;
+}
+
+void ByteRing_destroy(ByteRing* this) {
+    pthread_mutex_destroy(&(this->mutex));
+    pthread_cond_destroy(&(this->notFull));
+    pthread_cond_destroy(&(this->notEmpty));
+    free(this->buffer);
+    free(this);
+}
@@ -0,0 +1,113 @@
+/*
+ * ByteRing.h
+ *
+ * Module interface for a blocking ring of variable-length byte records.
+ *
+ * A producer reserves n contiguous bytes, writes the message in place and commits it; a
+ * consumer reads a pointer/length view of the oldest record and releases it when done,
+ * so framed data is handed over without a per-message allocation or copy.
+ * Each record starts with a header holding its length; a reservation that would straddle
+ * the end of the buffer is preceded by a padding record filling the rest of it.
+ * Records are delivered in reservation order: an uncommitted record holds back later ones.
+ *
+ */
+
+#ifndef BYTE_RING_H_
+#define BYTE_RING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/*
+ * Alignment of every record header and payload, and the size of a header.
+ */
+#define BYTE_RING_ALIGN 16
+
+typedef struct ByteRing ByteRing;
+
+/*
+ * Header at the start of every record.
+ */
+typedef struct ByteRingRecord {
+    /* Bytes from this header to the next one. */
+    uint32_t span;
+    /* Payload bytes, as committed. */
+    uint32_t length;
+    /* One of the record states in ByteRing.c. */
+    uint32_t state;
+    uint32_t unused;
+} ByteRingRecord;
+
+/*
+ * Offsets below grow without wrapping; the buffer position is the offset modulo capacity.
+ * Records between head and readCursor are being read or awaiting reclaim, and those
+ * between readCursor and tail are reserved or committed but not yet read.
+ */
+struct ByteRing {
+    unsigned char *buffer;
+    size_t capacity;
+    uint64_t head;
+    uint64_t readCursor;
+    uint64_t tail;
+    pthread_mutex_t mutex;
+    pthread_cond_t notFull;
+    pthread_cond_t notEmpty;
+};
+
+/*
+ * Creates a new ByteRing of capacity bytes, rounded up to a multiple of BYTE_RING_ALIGN.
+ * capacity may be at most UINT32_MAX rounded down to that multiple.
+ * Returns a pointer to a new ByteRing on success and NULL on failure.
+ */
+ByteRing* new_ByteRing(size_t capacity);
+
+/*
+ * Reserves length contiguous bytes at the back of this ring for the caller to write.
+ * If there is not enough free space, the function will block the calling thread until there is.
+ * Returns a pointer to the bytes, aligned to BYTE_RING_ALIGN, or NULL when the record
+ * could never fit in the ring.
+ */
+void* ByteRing_reserve(ByteRing* this, size_t length);
+
+/*
+ * Publishes a record returned by ByteRing_reserve, keeping its first length bytes.
+ * length may be smaller than the reserved length; the unused bytes are not reclaimed until the record is.
+ */
+void ByteRing_commit(ByteRing* this, void* data, size_t length);
+
+/*
+ * Takes the oldest committed record from this ring, storing its length in *length.
+ * If there is none, the function will block the calling thread until one is committed.
+ * Returns a pointer to the payload, which stays valid until ByteRing_release.
+ */
+const void* ByteRing_read(ByteRing* this, size_t* length);
+
+/*
+ * Like ByteRing_read, but returns NULL immediately when no committed record is available.
+ */
+const void* ByteRing_tryRead(ByteRing* this, size_t* length);
+
+/*
+ * Returns a record obtained from ByteRing_read or ByteRing_tryRead, freeing its space
+ * once every older record has been released as well.
+ */
+void ByteRing_release(ByteRing* this, const void* data);
+
+/*
+ * Returns the number of bytes, headers and padding included, not yet reclaimed.
+ */
+size_t ByteRing_usedBytes(ByteRing* this);
+
+/*
+ * Returns the number of bytes this ring can hold, headers and padding included.
+ */
+size_t ByteRing_capacity(ByteRing* this);
+
+/*
+ * Destroys this ring by freeing the memory used. No record may still be in use.
+ */
+void ByteRing_destroy(ByteRing* this);
+
+#endif /* BYTE_RING_H_ */
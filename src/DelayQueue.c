@@ -0,0 +1,394 @@
+/*
+ * DelayQueue.c
+ *
+ * Blocking delay queue backed by a four-level hierarchical timing wheel.
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "DelayQueue.h"
+
+/*
+ * Timer nodes are allocated in chunks of this many nodes and recycled through a free list.
+ */
+#define DELAY_QUEUE_CHUNK_BITS 12
+#define DELAY_QUEUE_CHUNK_SIZE (1 << DELAY_QUEUE_CHUNK_BITS)
+
+/*
+ * Pseudo-levels for nodes that are not in a wheel slot.
+ */
+#define LEVEL_READY (-1)
+#define LEVEL_FREE (-2)
+
+/*
+ * Furthest tick offset the wheel can represent; later timers are re-placed when cascaded.
+ */
+#define MAX_WHEEL_DELTA ((1ULL << (DELAY_QUEUE_SLOT_BITS * DELAY_QUEUE_LEVELS)) - 1)
+
+/*
+ * Returns the node with the given index.
+ */
+static DelayTimer *node(DelayQueue* this, int32_t index) {
+    return &(this->chunks[index >> DELAY_QUEUE_CHUNK_BITS][index & (DELAY_QUEUE_CHUNK_SIZE - 1)]);
+}
+
+/*
+ * Returns the head of the list a node with the given level and slot belongs to.
+ */
+static int32_t *listHead(DelayQueue* this, int level, int slot) {
+    return level == LEVEL_READY ? &(this->readyHead) : &(this->wheel[level][slot]);
+}
+
+/*
+ * Returns the tail of the list a node with the given level and slot belongs to.
+ */
+static int32_t *listTail(DelayQueue* this, int level, int slot) {
+    return level == LEVEL_READY ? &(this->readyTail) : &(this->wheelTail[level][slot]);
+}
+
+/*
+ * Appends a node to the list with the given level and slot, so nodes due together stay in FIFO order.
+ */
+static void append(DelayQueue* this, int32_t index, int level, int slot) {
+    DelayTimer *timer = node(this, index);
+    int32_t *tail = listTail(this, level, slot);
+    timer->level = (int16_t) level;
+    timer->slot = (int16_t) slot;
+    timer->next = -1;
+    timer->prev = *tail;
+    if (*tail >= 0) {
+        node(this, *tail)->next = index;
+    } else {
+        *listHead(this, level, slot) = index;
+    }
+    *tail = index;
+}
+
+/*
+ * Takes a node from the free list or fresh chunk storage.
+ * Returns the node index or -1 if memory runs out.
+ */
+static int32_t allocNode(DelayQueue* this) {
+    if (this->freeList >= 0) {
+        int32_t index = this->freeList;
+        this->freeList = node(this, index)->next;
+        return index;
+    }
+
+    if (this->numNodes == this->numChunks * DELAY_QUEUE_CHUNK_SIZE) {
+        DelayTimer **chunks = (DelayTimer**) realloc(this->chunks, sizeof(DelayTimer*) * (this->numChunks + 1));
+        if (chunks == NULL) {
+            return -1;
+        }
+        this->chunks = chunks;
+        this->chunks[this->numChunks] = (DelayTimer*) malloc(sizeof(DelayTimer) * DELAY_QUEUE_CHUNK_SIZE);
+        if (this->chunks[this->numChunks] == NULL) {
+            return -1;
+        }
+        this->numChunks++;
+    }
+
+    int32_t index = this->numNodes++;
+    node(this, index)->generation = 1;
+    return index;
+}
+
+/*
+ * Returns a node to the free list, invalidating every id that refers to it.
+ */
+static void freeNode(DelayQueue* this, int32_t index) {
+    DelayTimer *timer = node(this, index);
+    timer->element = NULL;
+    timer->level = LEVEL_FREE;
+    timer->generation++;
+    timer->next = this->freeList;
+    this->freeList = index;
+}
+
+/*
+ * Appends a node to the ready list.
+ */
+static void pushReady(DelayQueue* this, int32_t index) {
+    append(this, index, LEVEL_READY, 0);
+    this->ready++;
+}
+
+/*
+ * Places a node in the wheel slot matching its due tick, or on the ready list if it is due.
+ */
+static void place(DelayQueue* this, int32_t index) {
+    DelayTimer *timer = node(this, index);
+    if (timer->dueTick <= this->currentTick) {
+        pushReady(this, index);
+        return;
+    }
+
+    uint64_t delta = timer->dueTick - this->currentTick;
+    uint64_t target = timer->dueTick;
+    if (delta > MAX_WHEEL_DELTA) {
+        delta = MAX_WHEEL_DELTA;
+        target = this->currentTick + MAX_WHEEL_DELTA;
+    }
+
+    int level = 0;
+    while (level < DELAY_QUEUE_LEVELS - 1 && delta >= (1ULL << (DELAY_QUEUE_SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    int slot = (int) ((target >> (DELAY_QUEUE_SLOT_BITS * level)) & (DELAY_QUEUE_SLOTS - 1));
+
+    append(this, index, level, slot);
+    this->pending++;
+}
+
+/*
+ * Removes a node from whichever wheel slot or ready list currently holds it.
+ */
+static void detach(DelayQueue* this, int32_t index) {
+    DelayTimer *timer = node(this, index);
+    if (timer->prev >= 0) {
+        node(this, timer->prev)->next = timer->next;
+    } else {
+        *listHead(this, timer->level, timer->slot) = timer->next;
+    }
+    if (timer->next >= 0) {
+        node(this, timer->next)->prev = timer->prev;
+    } else {
+        *listTail(this, timer->level, timer->slot) = timer->prev;
+    }
+
+    if (timer->level == LEVEL_READY) {
+        this->ready--;
+    } else {
+        this->pending--;
+    }
+}
+
+/*
+ * Detaches a whole wheel slot and places each of its nodes again relative to the current tick.
+ */
+static void cascade(DelayQueue* this, int level, int slot) {
+    int32_t index = this->wheel[level][slot];
+    this->wheel[level][slot] = -1;
+    this->wheelTail[level][slot] = -1;
+    while (index >= 0) {
+        int32_t next = node(this, index)->next;
+        this->pending--;
+        place(this, index);
+        index = next;
+    }
+}
+
+/*
+ * Advances the wheel one tick at a time up to target, moving due nodes to the ready list.
+ * Must be called with the mutex held.
+ */
+static void advance(DelayQueue* this, uint64_t target) {
+    while (this->currentTick < target) {
+        if (this->pending == 0) {
+            this->currentTick = target;
+            return;
+        }
+        this->currentTick++;
+
+        int top = 0;
+        while (top < DELAY_QUEUE_LEVELS - 1
+                && (this->currentTick & ((1ULL << (DELAY_QUEUE_SLOT_BITS * (top + 1))) - 1)) == 0) {
+            top++;
+        }
+        for (int level = top; level >= 0; level--) {
+            cascade(this, level, (int) ((this->currentTick >> (DELAY_QUEUE_SLOT_BITS * level)) & (DELAY_QUEUE_SLOTS - 1)));
+        }
+    }
+}
+
+/*
+ * Returns the next tick at which a wheel slot expires or cascades.
+ * Must be called with the mutex held and at least one node in the wheel.
+ */
+static uint64_t nextEventTick(DelayQueue* this) {
+    uint64_t next = UINT64_MAX;
+    for (int level = 0; level < DELAY_QUEUE_LEVELS; level++) {
+        int shift = DELAY_QUEUE_SLOT_BITS * level;
+        uint64_t base = this->currentTick >> shift;
+        for (uint64_t i = 1; i <= DELAY_QUEUE_SLOTS; i++) {
+            if (this->wheel[level][(base + i) & (DELAY_QUEUE_SLOTS - 1)] >= 0) {
+                uint64_t tick = (base + i) << shift;
+                next = tick < next ? tick : next;
+                break;
+            }
+        }
+    }
+    return next;
+}
+
+/*
+ * Returns the tick containing the given time, rounding up.
+ */
+static uint64_t tickOf(DelayQueue* this, uint64_t ms) {
+    return (ms + this->tickMs - 1) / this->tickMs;
+}
+
+/*
+ * Removes and returns the head of the ready list. Must be called with the mutex held.
+ */
+static void* popReady(DelayQueue* this) {
+    int32_t index = this->readyHead;
+    void* element = node(this, index)->element;
+    detach(this, index);
+    freeNode(this, index);
+    return element;
+}
+
+uint64_t DelayQueue_nowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000;
+}
+
+DelayQueue *new_DelayQueue(uint64_t tick_ms) {
+    if (tick_ms == 0) {
+        return NULL;
+    }
+
+    DelayQueue* queue = (DelayQueue*) malloc(sizeof(DelayQueue));
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    queue->chunks = NULL;
+    queue->numChunks = 0;
+    queue->numNodes = 0;
+    queue->freeList = -1;
+    for (int level = 0; level < DELAY_QUEUE_LEVELS; level++) {
+        for (int slot = 0; slot < DELAY_QUEUE_SLOTS; slot++) {
+            queue->wheel[level][slot] = -1;
+            queue->wheelTail[level][slot] = -1;
+        }
+    }
+    queue->readyHead = -1;
+    queue->readyTail = -1;
+    queue->tickMs = tick_ms;
+    queue->currentTick = DelayQueue_nowMs() / tick_ms;
+    queue->pending = 0;
+    queue->ready = 0;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&(queue->changed), &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&(queue->mutex), NULL);
+
+    return queue;
+}
+
+DelayTimerId DelayQueue_enqAt(DelayQueue* this, void* element, uint64_t due_ms) {
+    if (element == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&(this->mutex));
+
+    int32_t index = allocNode(this);
+    if (index < 0) {
+        pthread_mutex_unlock(&(this->mutex));
+        return 0;
+    }
+    DelayTimer *timer = node(this, index);
+    timer->element = element;
+    timer->dueTick = tickOf(this, due_ms);
+    place(this, index);
+    DelayTimerId id = ((uint64_t) timer->generation << 32) | (uint32_t) (index + 1);
+
+    pthread_mutex_unlock(&(this->mutex));
+    pthread_cond_signal(&(this->changed));
+
+    return id;
+}
+
+DelayTimerId DelayQueue_enq(DelayQueue* this, void* element, uint64_t delay_ms) {
+    return DelayQueue_enqAt(this, element, DelayQueue_nowMs() + delay_ms);
+}
+
+bool DelayQueue_cancel(DelayQueue* this, DelayTimerId id) {
+    int64_t index = (int64_t) (id & 0xffffffffu) - 1;
+    uint32_t generation = (uint32_t) (id >> 32);
+    bool cancelled = false;
+
+    pthread_mutex_lock(&(this->mutex));
+    if (index >= 0 && index < this->numNodes) {
+        DelayTimer *timer = node(this, (int32_t) index);
+        if (timer->generation == generation && timer->level != LEVEL_FREE) {
+            detach(this, (int32_t) index);
+            freeNode(this, (int32_t) index);
+            cancelled = true;
+        }
+    }
+    pthread_mutex_unlock(&(this->mutex));
+
+    return cancelled;
+}
+
+void* DelayQueue_deq(DelayQueue* this) {
+    pthread_mutex_lock(&(this->mutex));
+    for (;;) {
+        advance(this, DelayQueue_nowMs() / this->tickMs);
+        if (this->readyHead >= 0) {
+            break;
+        }
+
+        if (this->pending == 0) {
+            pthread_cond_wait(&(this->changed), &(this->mutex));
+        } else {
+            uint64_t wakeMs = nextEventTick(this) * this->tickMs;
+            struct timespec ts = { (time_t) (wakeMs / 1000), (long) (wakeMs % 1000) * 1000000 };
+            pthread_cond_timedwait(&(this->changed), &(this->mutex), &ts);
+        }
+    }
+
+    void* element = popReady(this);
+    bool more = this->readyHead >= 0;
+    pthread_mutex_unlock(&(this->mutex));
+    if (more) {
+        pthread_cond_signal(&(this->changed));
+    }
+
+    return element;
+}
+
+void* DelayQueue_tryDeq(DelayQueue* this) {
+    void* element = NULL;
+    pthread_mutex_lock(&(this->mutex));
+    advance(this, DelayQueue_nowMs() / this->tickMs);
+    if (this->readyHead >= 0) {
+        element = popReady(this);
+    }
+    pthread_mutex_unlock(&(this->mutex));
+    return element;
+}
+
+int DelayQueue_size(DelayQueue* this) {
+    pthread_mutex_lock(&(this->mutex));
+    int size = this->pending + this->ready;
+    pthread_mutex_unlock(&(this->mutex));
+    return size;
+}
+
+bool DelayQueue_isEmpty(DelayQueue* this) {
+    return DelayQueue_size(this) == 0;
+}
+
+void DelayQueue_destroy(DelayQueue* this) {
+    for (int i = 0; i < this->numChunks; i++) {
+        free(this->chunks[i]);
+    }
+    free(this->chunks);
+    pthread_mutex_destroy(&(this->mutex));
+    pthread_cond_destroy(&(this->changed));
+    free(this);
+}
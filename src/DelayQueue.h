@@ -0,0 +1,117 @@
+/*
+ * DelayQueue.h
+ *
+ * Module interface for a Blocking Delay Queue backed by a hierarchical timing wheel.
+ *
+ * Each element is enqueued with a due time and only becomes available to
+ * DelayQueue_deq once that time has passed. Pending elements are kept in four levels of
+ * 256 slots each, so insertion, cancellation and expiry are O(1) amortized, and timer
+ * nodes are recycled from chunked storage so millions of pending timers cost 32 bytes each.
+ *
+ */
+
+#ifndef DELAY_QUEUE_H_
+#define DELAY_QUEUE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#define DELAY_QUEUE_LEVELS 4
+#define DELAY_QUEUE_SLOT_BITS 8
+#define DELAY_QUEUE_SLOTS (1 << DELAY_QUEUE_SLOT_BITS)
+
+/*
+ * Identifies one pending element for DelayQueue_cancel. Zero is never a valid id.
+ */
+typedef uint64_t DelayTimerId;
+
+typedef struct DelayTimer DelayTimer;
+typedef struct DelayQueue DelayQueue;
+
+struct DelayTimer {
+    void *element;
+    uint64_t dueTick;
+    int32_t next;
+    int32_t prev;
+    uint32_t generation;
+    int16_t level;
+    int16_t slot;
+};
+
+struct DelayQueue {
+    DelayTimer **chunks;
+    int numChunks;
+    int numNodes;
+    int32_t freeList;
+    int32_t wheel[DELAY_QUEUE_LEVELS][DELAY_QUEUE_SLOTS];
+    int32_t wheelTail[DELAY_QUEUE_LEVELS][DELAY_QUEUE_SLOTS];
+    int32_t readyHead;
+    int32_t readyTail;
+    uint64_t tickMs;
+    uint64_t currentTick;
+    int pending;
+    int ready;
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+};
+
+/*
+ * Creates a new DelayQueue that checks due times with a resolution of tick_ms milliseconds.
+ * Returns a pointer to a new DelayQueue on success and NULL on failure.
+ */
+DelayQueue* new_DelayQueue(uint64_t tick_ms);
+
+/*
+ * Returns the current time in milliseconds on the monotonic clock used for due times.
+ */
+uint64_t DelayQueue_nowMs();
+
+/*
+ * Enqueues the given void* element to become available at due_ms (see DelayQueue_nowMs).
+ * Returns an id for DelayQueue_cancel, or 0 when element is NULL or memory runs out.
+ */
+DelayTimerId DelayQueue_enqAt(DelayQueue* this, void* element, uint64_t due_ms);
+
+/*
+ * Enqueues the given void* element to become available delay_ms milliseconds from now.
+ * Returns an id for DelayQueue_cancel, or 0 when element is NULL or memory runs out.
+ */
+DelayTimerId DelayQueue_enq(DelayQueue* this, void* element, uint64_t delay_ms);
+
+/*
+ * Cancels the pending element with the given id.
+ * Returns true if it was removed, false if it was already dequeued or cancelled.
+ */
+bool DelayQueue_cancel(DelayQueue* this, DelayTimerId id);
+
+/*
+ * Dequeues the element that became due first.
+ * If no element is due, the function will block until one is.
+ * Returns the dequeued void* element.
+ */
+void* DelayQueue_deq(DelayQueue* this);
+
+/*
+ * Dequeues a due element without blocking.
+ * Returns the dequeued void* element or NULL if no element is due yet.
+ */
+void* DelayQueue_tryDeq(DelayQueue* this);
+
+/*
+ * Returns the number of elements in this Queue, due or not.
+ */
+int DelayQueue_size(DelayQueue* this);
+
+/*
+ * Returns true if this Queue is empty, false otherwise.
+ */
+bool DelayQueue_isEmpty(DelayQueue* this);
+
+/*
+ * Destroys this Queue by freeing the memory used by the Queue.
+ */
+void DelayQueue_destroy(DelayQueue* this);
+
+#endif /* DELAY_QUEUE_H_ */
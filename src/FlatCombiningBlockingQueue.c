@@ -0,0 +1,217 @@
+/*
+ * FlatCombiningBlockingQueue.c
+ *
+ * Fixed-size generic ring-buffer BlockingQueue whose operations are applied in batches by a combiner thread.
+ *
+ */
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "FlatCombiningBlockingQueue.h"
+
+/*
+ * Slot states: free to claim, claimed by a thread writing its operation, posted for the
+ * combiner, and done with the result waiting for its owner.
+ */
+enum {
+    SLOT_FREE,
+    SLOT_CLAIMED,
+    SLOT_POSTED,
+    SLOT_DONE
+};
+
+/*
+ * Number of times a waiting thread yields before blocking on the combiner lock.
+ */
+#define SPIN_LIMIT 64
+
+/*
+ * Most passes a combiner makes over the slots while it keeps finding posted operations.
+ */
+#define COMBINING_PASSES 4
+
+/*
+ * Per-thread starting point for slot probing, so threads usually find their own slot free.
+ */
+static atomic_uint nextSlotHint = 0;
+static __thread unsigned slotHint;
+static __thread bool slotHintSet;
+
+/*
+ * Claims a free publication slot, probing from the calling thread's usual slot.
+ * Yields while every slot is taken.
+ */
+static FlatCombiningSlot *claimSlot(FlatCombiningBlockingQueue* this) {
+    if (!slotHintSet) {
+        slotHint = atomic_fetch_add(&nextSlotHint, 1);
+        slotHintSet = true;
+    }
+
+    for (;;) {
+        for (int probe = 0; probe < FLAT_COMBINING_SLOTS; probe++) {
+            int index = (int) ((slotHint + probe) % FLAT_COMBINING_SLOTS);
+            FlatCombiningSlot *slot = &(this->slots[index]);
+            int expected = SLOT_FREE;
+            if (atomic_load_explicit(&(slot->state), memory_order_relaxed) == SLOT_FREE
+                    && atomic_compare_exchange_strong(&(slot->state), &expected, SLOT_CLAIMED)) {
+                int used = atomic_load(&(this->usedSlots));
+                while (used <= index && !atomic_compare_exchange_weak(&(this->usedSlots), &used, index + 1)) {
+                }
+                return slot;
+            }
+        }
+        sched_yield();
+    }
+}
+
+/*
+ * Applies every posted operation, making up to COMBINING_PASSES passes while new ones keep arriving.
+ * Must be called with the combiner mutex held.
+ */
+static void combine(FlatCombiningBlockingQueue* this) {
+    for (int pass = 0; pass < COMBINING_PASSES; pass++) {
+        int used = atomic_load(&(this->usedSlots));
+        size_t size = atomic_load_explicit(&(this->size), memory_order_relaxed);
+        int applied = 0;
+
+        for (int i = 0; i < used; i++) {
+            FlatCombiningSlot *slot = &(this->slots[i]);
+            if (atomic_load_explicit(&(slot->state), memory_order_acquire) != SLOT_POSTED) {
+                continue;
+            }
+            if (slot->enq) {
+                size_t tail = this->head + size;
+                this->array[tail >= this->maxSize ? tail - this->maxSize : tail] = slot->element;
+                size++;
+            } else {
+                slot->element = this->array[this->head];
+                this->head = this->head + 1 == this->maxSize ? 0 : this->head + 1;
+                size--;
+            }
+            atomic_store_explicit(&(slot->state), SLOT_DONE, memory_order_release);
+            applied++;
+        }
+
+        atomic_store_explicit(&(this->size), size, memory_order_relaxed);
+        if (applied == 0) {
+            return;
+        }
+    }
+}
+
+/*
+ * Posts an operation and returns once it has been applied, combining when the lock is free.
+ * Returns the slot's element: the dequeued element for a dequeue.
+ */
+static void *apply(FlatCombiningBlockingQueue* this, bool enq, void* element) {
+    FlatCombiningSlot *slot = claimSlot(this);
+    slot->enq = enq;
+    slot->element = element;
+    atomic_store_explicit(&(slot->state), SLOT_POSTED, memory_order_release);
+
+    int spins = 0;
+    while (atomic_load_explicit(&(slot->state), memory_order_acquire) != SLOT_DONE) {
+        if (spins < SPIN_LIMIT) {
+            spins++;
+            if (pthread_mutex_trylock(&(this->combinerMutex)) != 0) {
+                sched_yield();
+                continue;
+            }
+        } else {
+            pthread_mutex_lock(&(this->combinerMutex));
+        }
+        combine(this);
+        pthread_mutex_unlock(&(this->combinerMutex));
+    }
+
+    void *result = slot->element;
+    atomic_store_explicit(&(slot->state), SLOT_FREE, memory_order_release);
+    return result;
+}
+
+FlatCombiningBlockingQueue *new_FlatCombiningBlockingQueue(size_t max_size) {
+    if (max_size == 0 || max_size > SEM_VALUE_MAX) {
+        return NULL;
+    }
+
+    FlatCombiningBlockingQueue* queue = (FlatCombiningBlockingQueue*) aligned_alloc(FLAT_COMBINING_CACHE_LINE,
+            sizeof(FlatCombiningBlockingQueue));
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    queue->array = (void**) malloc(sizeof(void*) * max_size);
+    if (queue->array == NULL) {
+        free(queue);
+        return NULL;
+    }
+
+    queue->maxSize = max_size;
+    atomic_init(&(queue->size), 0);
+    queue->head = 0;
+    sem_init(&(queue->full), 0, 0);
+    sem_init(&(queue->empty), 0, (unsigned int) max_size);
+    pthread_mutex_init(&(queue->combinerMutex), NULL);
+    atomic_init(&(queue->usedSlots), 0);
+    for (int i = 0; i < FLAT_COMBINING_SLOTS; i++) {
+        atomic_init(&(queue->slots[i].state), SLOT_FREE);
+        queue->slots[i].enq = false;
+        queue->slots[i].element = NULL;
+    }
+
+    return queue;
+}
+
+bool FlatCombiningBlockingQueue_enq(FlatCombiningBlockingQueue* this, void* element) {
+    if (element == NULL) {
+        return false;
+    }
+
+    sem_wait(&(this->empty));
+    apply(this, true, element);
+    sem_post(&(this->full));
+
+    return true;
+}
+
+void* FlatCombiningBlockingQueue_deq(FlatCombiningBlockingQueue* this) {
+    sem_wait(&(this->full));
+    void* data = apply(this, false, NULL);
+    sem_post(&(this->empty));
+
+    return data;
+}
+
+size_t FlatCombiningBlockingQueue_size(FlatCombiningBlockingQueue* this) {
+    return atomic_load_explicit(&(this->size), memory_order_relaxed);
+}
+
+bool FlatCombiningBlockingQueue_isEmpty(FlatCombiningBlockingQueue* this) {
+    return FlatCombiningBlockingQueue_size(this) == 0;
+}
+
+void FlatCombiningBlockingQueue_clear(FlatCombiningBlockingQueue* this) {
+    /* Holding the combiner lock gives direct access to the ring; only unclaimed elements are removed. */
+    pthread_mutex_lock(&(this->combinerMutex));
+    combine(this);
+    while (sem_trywait(&(this->full)) == 0) {
+        this->head = this->head + 1 == this->maxSize ? 0 : this->head + 1;
+        atomic_fetch_sub_explicit(&(this->size), 1, memory_order_relaxed);
+        sem_post(&(this->empty));
+    }
+    pthread_mutex_unlock(&(this->combinerMutex));
+}
+
+void FlatCombiningBlockingQueue_destroy(FlatCombiningBlockingQueue* this) {
+    free(this->array);
+    pthread_mutex_destroy(&(this->combinerMutex));
+    sem_destroy(&(this->full));
+    sem_destroy(&(this->empty));
+    free(this);
+}
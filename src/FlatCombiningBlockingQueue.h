@@ -0,0 +1,98 @@
+/*
+ * FlatCombiningBlockingQueue.h
+ *
+ * Module interface for a generic fixed-size Blocking Queue using flat combining.
+ *
+ * Instead of every thread taking the lock to touch the ring, a thread posts its enqueue or
+ * dequeue to a publication slot and then either waits for it to be done or, if it gets the
+ * combiner lock, applies every posted operation in one pass while the ring stays in its
+ * cache. The full/empty semaphores are taken before posting, exactly as BlockingQueue takes
+ * them before locking, so a posted operation can always be applied and blocking when full
+ * or empty behaves the same.
+ *
+ */
+
+#ifndef FLAT_COMBINING_BLOCKING_QUEUE_H_
+#define FLAT_COMBINING_BLOCKING_QUEUE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdlib.h>
+
+#define FLAT_COMBINING_CACHE_LINE 64
+#define FLAT_COMBINING_SLOTS 128
+
+typedef struct FlatCombiningBlockingQueue FlatCombiningBlockingQueue;
+
+/*
+ * Publication slot through which one thread at a time hands an operation to the combiner.
+ */
+typedef struct FlatCombiningSlot {
+    /* One of the slot states in FlatCombiningBlockingQueue.c. */
+    _Alignas(FLAT_COMBINING_CACHE_LINE) atomic_int state;
+    bool enq;
+    /* The element to enqueue, or the dequeued element once done. */
+    void *element;
+} FlatCombiningSlot;
+
+struct FlatCombiningBlockingQueue {
+    void **array;
+    size_t maxSize;
+    atomic_size_t size;
+    size_t head;
+    sem_t full;
+    sem_t empty;
+
+    /* Held by the thread currently combining; it alone touches the ring. */
+    _Alignas(FLAT_COMBINING_CACHE_LINE) pthread_mutex_t combinerMutex;
+    /* One more than the highest slot index ever claimed, bounding the combiner's scan. */
+    atomic_int usedSlots;
+
+    FlatCombiningSlot slots[FLAT_COMBINING_SLOTS];
+};
+
+/*
+ * Creates a new FlatCombiningBlockingQueue for at most max_size void* elements.
+ * max_size may be at most SEM_VALUE_MAX.
+ * Returns a pointer to a new FlatCombiningBlockingQueue on success and NULL on failure.
+ */
+FlatCombiningBlockingQueue* new_FlatCombiningBlockingQueue(size_t max_size);
+
+/*
+ * Enqueues the given void* element at the back of this Queue.
+ * If the queue is full, the function will block the calling thread until there is space in the queue.
+ * Returns false when element is NULL and true on success.
+ */
+bool FlatCombiningBlockingQueue_enq(FlatCombiningBlockingQueue* this, void* element);
+
+/*
+ * Dequeues an element from the front of this Queue.
+ * If the queue is empty, the function will block until an element can be dequeued.
+ * Returns the dequeued void* element.
+ */
+void* FlatCombiningBlockingQueue_deq(FlatCombiningBlockingQueue* this);
+
+/*
+ * Returns the number of elements currently in this Queue.
+ */
+size_t FlatCombiningBlockingQueue_size(FlatCombiningBlockingQueue* this);
+
+/*
+ * Returns true if this Queue is empty, false otherwise.
+ */
+bool FlatCombiningBlockingQueue_isEmpty(FlatCombiningBlockingQueue* this);
+
+/*
+ * Clears this Queue returning it to an empty state.
+ */
+void FlatCombiningBlockingQueue_clear(FlatCombiningBlockingQueue* this);
+
+/*
+ * Destroys this Queue by freeing the memory used by the Queue.
+ */
+void FlatCombiningBlockingQueue_destroy(FlatCombiningBlockingQueue* this);
+
+#endif /* FLAT_COMBINING_BLOCKING_QUEUE_H_ */
@@ -0,0 +1,236 @@
+/*
+ * MessagePool.c
+ *
+ * Fixed-size message buffer pool with a lock-free return stack and optional per-thread caches.
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "MessagePool.h"
+
+/*
+ * Buffers are rounded up to this many bytes so each one starts on its own cache line.
+ */
+#define MESSAGE_POOL_ALIGN 64
+
+/*
+ * Packs an ABA tag and a buffer index (or -1 for an empty stack) into a stack head.
+ */
+static uint64_t packHead(uint32_t tag, int index) {
+    return ((uint64_t) tag << 32) | (uint32_t) (index + 1);
+}
+
+/*
+ * Returns the buffer index stored in a stack head, or -1 if the stack is empty.
+ */
+static int headIndex(uint64_t head) {
+    return (int) (head & 0xffffffffu) - 1;
+}
+
+/*
+ * Returns the ABA tag stored in a stack head.
+ */
+static uint32_t headTag(uint64_t head) {
+    return (uint32_t) (head >> 32);
+}
+
+/*
+ * Returns the index of buffer in this pool or -1 if it does not belong to the pool.
+ */
+static int bufferIndex(MessagePool* this, void* buffer) {
+    char *p = (char *) buffer;
+    if (p < this->storage || p >= this->storage + this->bufferSize * this->numBuffers) {
+        return -1;
+    }
+    size_t offset = (size_t) (p - this->storage);
+    if (offset % this->bufferSize != 0) {
+        return -1;
+    }
+    return (int) (offset / this->bufferSize);
+}
+
+/*
+ * Pushes the buffer with the given index onto the free stack.
+ */
+static void pushFree(MessagePool* this, int index) {
+    uint64_t head = atomic_load_explicit(&(this->freeHead), memory_order_relaxed);
+    uint64_t newHead;
+    do {
+        atomic_store_explicit(&(this->next[index]), headIndex(head), memory_order_relaxed);
+        newHead = packHead(headTag(head) + 1, index);
+    } while (!atomic_compare_exchange_weak_explicit(&(this->freeHead), &head, newHead,
+            memory_order_release, memory_order_relaxed));
+}
+
+/*
+ * Pops a buffer index off the free stack.
+ * Returns the index or -1 if the stack is empty.
+ */
+static int popFree(MessagePool* this) {
+    uint64_t head = atomic_load_explicit(&(this->freeHead), memory_order_acquire);
+    uint64_t newHead;
+    int index;
+    do {
+        index = headIndex(head);
+        if (index < 0) {
+            return -1;
+        }
+        int next = atomic_load_explicit(&(this->next[index]), memory_order_relaxed);
+        newHead = packHead(headTag(head) + 1, next);
+    } while (!atomic_compare_exchange_weak_explicit(&(this->freeHead), &head, newHead,
+            memory_order_acquire, memory_order_acquire));
+    return index;
+}
+
+MessagePool *new_MessagePool(int num_buffers, size_t buffer_size) {
+    if (num_buffers <= 0 || buffer_size == 0 || buffer_size > SIZE_MAX - (MESSAGE_POOL_ALIGN - 1)
+            || (buffer_size + MESSAGE_POOL_ALIGN - 1) / MESSAGE_POOL_ALIGN * MESSAGE_POOL_ALIGN
+                    > SIZE_MAX / (size_t) num_buffers) {
+        return NULL;
+    }
+
+    MessagePool* pool = (MessagePool*) malloc(sizeof(MessagePool));
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    pool->bufferSize = (buffer_size + MESSAGE_POOL_ALIGN - 1) / MESSAGE_POOL_ALIGN * MESSAGE_POOL_ALIGN;
+    pool->numBuffers = num_buffers;
+    pool->storage = (char*) aligned_alloc(MESSAGE_POOL_ALIGN, pool->bufferSize * num_buffers);
+    pool->next = (atomic_int*) malloc(sizeof(atomic_int) * num_buffers);
+    if (pool->storage == NULL || pool->next == NULL) {
+        free(pool->storage);
+        free(pool->next);
+        free(pool);
+        return NULL;
+    }
+
+    atomic_init(&(pool->freeHead), packHead(0, -1));
+    atomic_init(&(pool->acquired), 0);
+    atomic_init(&(pool->released), 0);
+    atomic_init(&(pool->exhausted), 0);
+    for (int i = num_buffers - 1; i >= 0; i--) {
+        atomic_init(&(pool->next[i]), -1);
+        pushFree(pool, i);
+    }
+
+    return pool;
+}
+
+void* MessagePool_acquire(MessagePool* this) {
+    int index = popFree(this);
+    if (index < 0) {
+        atomic_fetch_add_explicit(&(this->exhausted), 1, memory_order_relaxed);
+        return NULL;
+    }
+    atomic_fetch_add_explicit(&(this->acquired), 1, memory_order_relaxed);
+    return this->storage + this->bufferSize * index;
+}
+
+bool MessagePool_release(MessagePool* this, void* buffer) {
+    int index = bufferIndex(this, buffer);
+    if (index < 0) {
+        return false;
+    }
+    atomic_fetch_add_explicit(&(this->released), 1, memory_order_relaxed);
+    pushFree(this, index);
+    return true;
+}
+
+size_t MessagePool_bufferSize(MessagePool* this) {
+    return this->bufferSize;
+}
+
+void MessagePool_stats(MessagePool* this, MessagePoolStats* stats) {
+    stats->acquired = atomic_load_explicit(&(this->acquired), memory_order_relaxed);
+    stats->released = atomic_load_explicit(&(this->released), memory_order_relaxed);
+    stats->exhausted = atomic_load_explicit(&(this->exhausted), memory_order_relaxed);
+
+    /* Walking the stack is only exact while no other thread is using the pool. */
+    int available = 0;
+    int index = headIndex(atomic_load_explicit(&(this->freeHead), memory_order_acquire));
+    while (index >= 0 && available < this->numBuffers) {
+        available++;
+        index = atomic_load_explicit(&(this->next[index]), memory_order_relaxed);
+    }
+    stats->available = available;
+}
+
+void MessagePool_destroy(MessagePool* this) {
+    free(this->storage);
+    free(this->next);
+    free(this);
+}
+
+MessagePoolCache *new_MessagePoolCache(MessagePool* pool, int max_size) {
+    if (pool == NULL || max_size <= 0) {
+        return NULL;
+    }
+
+    MessagePoolCache* cache = (MessagePoolCache*) malloc(sizeof(MessagePoolCache));
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    cache->buffers = (void**) malloc(sizeof(void*) * max_size);
+    if (cache->buffers == NULL) {
+        free(cache);
+        return NULL;
+    }
+
+    cache->pool = pool;
+    cache->maxSize = max_size;
+    cache->size = 0;
+
+    return cache;
+}
+
+void* MessagePoolCache_acquire(MessagePoolCache* this) {
+    if (this->size == 0) {
+        int batch = (this->maxSize + 1) / 2;
+        for (int i = 0; i < batch; i++) {
+            int index = popFree(this->pool);
+            if (index < 0) {
+                break;
+            }
+            this->buffers[this->size++] = this->pool->storage + this->pool->bufferSize * index;
+        }
+        if (this->size == 0) {
+            atomic_fetch_add_explicit(&(this->pool->exhausted), 1, memory_order_relaxed);
+            return NULL;
+        }
+    }
+    atomic_fetch_add_explicit(&(this->pool->acquired), 1, memory_order_relaxed);
+    return this->buffers[--this->size];
+}
+
+bool MessagePoolCache_release(MessagePoolCache* this, void* buffer) {
+    if (bufferIndex(this->pool, buffer) < 0) {
+        return false;
+    }
+    if (this->size == this->maxSize) {
+        int keep = this->maxSize / 2;
+        while (this->size > keep) {
+            pushFree(this->pool, bufferIndex(this->pool, this->buffers[--this->size]));
+        }
+    }
+    atomic_fetch_add_explicit(&(this->pool->released), 1, memory_order_relaxed);
+    this->buffers[this->size++] = buffer;
+    return true;
+}
+
+void MessagePoolCache_flush(MessagePoolCache* this) {
+    while (this->size > 0) {
+        pushFree(this->pool, bufferIndex(this->pool, this->buffers[--this->size]));
+    }
+}
+
+void MessagePoolCache_destroy(MessagePoolCache* this) {
+    MessagePoolCache_flush(this);
+    free(this->buffers);
+    free(this);
+}
@@ -0,0 +1,118 @@
+/*
+ * MessagePool.h
+ *
+ * Module interface for a pool of pre-allocated fixed-size message buffers.
+ *
+ * A MessagePool is the companion of a BlockingQueue for allocation-free messaging:
+ * producers acquire a buffer from the pool, fill it and enqueue the pointer, and
+ * consumers release the buffer back to the pool once they are done with it.
+ * Buffers are returned through a lock-free stack, so releasing from any thread never
+ * blocks and never calls the allocator. A thread that acquires or releases at a high
+ * rate can additionally use a MessagePoolCache to move buffers in batches.
+ *
+ */
+
+#ifndef MESSAGE_POOL_H_
+#define MESSAGE_POOL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+typedef struct MessagePool MessagePool;
+typedef struct MessagePoolCache MessagePoolCache;
+typedef struct MessagePoolStats MessagePoolStats;
+
+struct MessagePool {
+    char *storage;
+    size_t bufferSize;
+    int numBuffers;
+    atomic_int *next;
+    /* Free stack head: ABA tag in the upper 32 bits, buffer index + 1 in the lower 32 bits. */
+    _Atomic uint64_t freeHead;
+    atomic_long acquired;
+    atomic_long released;
+    atomic_long exhausted;
+};
+
+struct MessagePoolCache {
+    MessagePool *pool;
+    void **buffers;
+    int maxSize;
+    int size;
+};
+
+struct MessagePoolStats {
+    long acquired;
+    long released;
+    long exhausted;
+    int available;
+};
+
+/*
+ * Creates a new MessagePool of num_buffers buffers of at least buffer_size bytes each.
+ * All memory is allocated here; no other MessagePool function allocates.
+ * Returns a pointer to a new MessagePool on success and NULL on failure.
+ */
+MessagePool* new_MessagePool(int num_buffers, size_t buffer_size);
+
+/*
+ * Takes a buffer out of this pool.
+ * Returns the buffer on success or NULL if the pool is exhausted, in which case the
+ * exhaustion counter is incremented.
+ */
+void* MessagePool_acquire(MessagePool* this);
+
+/*
+ * Returns a buffer previously acquired from this pool. Safe to call from any thread.
+ * Returns false if buffer is NULL or does not belong to this pool.
+ */
+bool MessagePool_release(MessagePool* this, void* buffer);
+
+/*
+ * Returns the usable size in bytes of each buffer in this pool.
+ */
+size_t MessagePool_bufferSize(MessagePool* this);
+
+/*
+ * Fills stats with the number of acquires, releases, failed acquires due to exhaustion
+ * and the number of buffers currently free in the shared stack.
+ */
+void MessagePool_stats(MessagePool* this, MessagePoolStats* stats);
+
+/*
+ * Destroys this pool by freeing all buffers. Buffers still in use become invalid.
+ */
+void MessagePool_destroy(MessagePool* this);
+
+/*
+ * Creates a new per-thread cache holding at most max_size buffers of the given pool.
+ * A cache must only be used by one thread at a time.
+ * Returns a pointer to a new MessagePoolCache on success and NULL on failure.
+ */
+MessagePoolCache* new_MessagePoolCache(MessagePool* pool, int max_size);
+
+/*
+ * Takes a buffer from this cache, refilling half the cache from the pool when it is empty.
+ * Returns the buffer on success or NULL if the pool is exhausted.
+ */
+void* MessagePoolCache_acquire(MessagePoolCache* this);
+
+/*
+ * Returns a buffer to this cache, spilling half the cache to the pool when it is full.
+ * Returns false if buffer is NULL or does not belong to the cache's pool.
+ */
+bool MessagePoolCache_release(MessagePoolCache* this, void* buffer);
+
+/*
+ * Returns every cached buffer to the pool.
+ */
+void MessagePoolCache_flush(MessagePoolCache* this);
+
+/*
+ * Flushes and destroys this cache.
+ */
+void MessagePoolCache_destroy(MessagePoolCache* this);
+
+#endif /* MESSAGE_POOL_H_ */
@@ -0,0 +1,155 @@
+/*
+ * PerfCounters.c
+ *
+ * perf_event_open based hardware counter collection with a clean fallback when counters
+ * are unavailable or the platform is not Linux.
+ *
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "PerfCounters.h"
+
+/*
+ * Names used when printing each counter.
+ */
+static const char *counterNames[PERF_NUM_COUNTERS] = {
+    "cycles", "instructions", "cache-misses", "branch-misses", "ctx-switches"
+};
+
+#ifdef __linux__
+/*
+ * Opens a single counter of the given type for the calling thread and its future children.
+ * Returns the counter descriptor or -1 if the counter is unavailable.
+ */
+static int openCounter(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    /* Hardware events are user-space only so they open under perf_event_paranoid 2. */
+    attr.exclude_kernel = (type == PERF_TYPE_HARDWARE);
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+PerfCounters *new_PerfCounters() {
+    PerfCounters* counters = (PerfCounters*) malloc(sizeof(PerfCounters));
+    if (counters == NULL) {
+        return NULL;
+    }
+
+    for (int i = 0; i < PERF_NUM_COUNTERS; i++) {
+        counters->fds[i] = -1;
+        counters->values[i] = 0;
+        counters->recorded[i] = false;
+        counters->multiplexed[i] = false;
+    }
+
+#ifdef __linux__
+    if (getenv("PERF_COUNTERS_DISABLE") == NULL) {
+        counters->fds[PERF_CYCLES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        counters->fds[PERF_INSTRUCTIONS] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        counters->fds[PERF_CACHE_MISSES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        counters->fds[PERF_BRANCH_MISSES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        counters->fds[PERF_CONTEXT_SWITCHES] = openCounter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+    }
+#endif
+
+    return counters;
+}
+
+bool PerfCounters_available(PerfCounters* this) {
+    for (int i = 0; i < PERF_NUM_COUNTERS; i++) {
+        if (this->fds[i] >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerfCounters_start(PerfCounters* this) {
+#ifdef __linux__
+    for (int i = 0; i < PERF_NUM_COUNTERS; i++) {
+        if (this->fds[i] >= 0) {
+            ioctl(this->fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(this->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    (void) this;
+#endif
+}
+
+void PerfCounters_stop(PerfCounters* this) {
+    for (int i = 0; i < PERF_NUM_COUNTERS; i++) {
+        this->values[i] = 0;
+        this->recorded[i] = false;
+        this->multiplexed[i] = false;
+        if (this->fds[i] < 0) {
+            continue;
+        }
+#ifdef __linux__
+        ioctl(this->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+#endif
+        /* Value, time enabled and time running, as requested by read_format. */
+        uint64_t data[3];
+        if (read(this->fds[i], data, sizeof(data)) == sizeof(data)) {
+            /* A counter that never got a PMU slot has no meaningful value. */
+            this->recorded[i] = data[2] > 0;
+            this->multiplexed[i] = data[2] > 0 && data[2] < data[1];
+            this->values[i] = this->multiplexed[i] ? (uint64_t) ((double) data[0] * data[1] / data[2]) : data[0];
+        } else {
+            close(this->fds[i]);
+            this->fds[i] = -1;
+        }
+    }
+}
+
+bool PerfCounters_get(PerfCounters* this, PerfCounterId id, uint64_t* value) {
+    if (id < 0 || id >= PERF_NUM_COUNTERS || !this->recorded[id]) {
+        return false;
+    }
+    *value = this->values[id];
+    return true;
+}
+
+void PerfCounters_print(PerfCounters* this, const char* label, long ops) {
+    if (ops <= 0) {
+        ops = 1;
+    }
+    printf("  %-26s", label);
+    for (int i = 0; i < PERF_NUM_COUNTERS; i++) {
+        uint64_t value;
+        if (PerfCounters_get(this, i, &value)) {
+            printf(" %s/op=%.3f%s", counterNames[i], (double) value / ops, this->multiplexed[i] ? "*" : "");
+        } else {
+            printf(" %s/op=n/a", counterNames[i]);
+        }
+    }
+    printf("\n");
+}
+
+void PerfCounters_destroy(PerfCounters* this) {
+    for (int i = 0; i < PERF_NUM_COUNTERS; i++) {
+        if (this->fds[i] >= 0) {
+            close(this->fds[i]);
+        }
+    }
+    free(this);
+}
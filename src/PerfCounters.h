@@ -0,0 +1,85 @@
+/*
+ * PerfCounters.h
+ *
+ * Module interface for collecting hardware performance counters around benchmark runs.
+ *
+ * Counters are opened with perf_event_open for the calling thread and every thread it
+ * creates afterwards. Any counter the kernel refuses to open (for example in a container
+ * or when perf_event_paranoid forbids it) is reported as unavailable instead of failing.
+ * Setting the PERF_COUNTERS_DISABLE environment variable skips opening counters entirely.
+ *
+ * Counts from threads created after new_PerfCounters are only folded in once those
+ * threads have exited, so join worker threads before calling PerfCounters_stop.
+ *
+ * When the kernel multiplexes more events than the PMU can count at once, each value is
+ * scaled by the time the event was enabled over the time it was actually counting, and
+ * the counter is marked multiplexed.
+ *
+ */
+
+#ifndef PERF_COUNTERS_H_
+#define PERF_COUNTERS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum PerfCounterId {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_CONTEXT_SWITCHES,
+    PERF_NUM_COUNTERS
+} PerfCounterId;
+
+typedef struct PerfCounters PerfCounters;
+
+struct PerfCounters {
+    int fds[PERF_NUM_COUNTERS];
+    uint64_t values[PERF_NUM_COUNTERS];
+    /* Set by PerfCounters_stop for counters that produced a value. */
+    bool recorded[PERF_NUM_COUNTERS];
+    /* Set for recorded counters that only counted for part of the time and were scaled up. */
+    bool multiplexed[PERF_NUM_COUNTERS];
+};
+
+/*
+ * Creates a new set of counters for the calling thread and threads it creates later.
+ * Returns a pointer to new PerfCounters on success and NULL on allocation failure.
+ * Counters that cannot be opened are left unavailable.
+ */
+PerfCounters* new_PerfCounters();
+
+/*
+ * Returns true if at least one counter could be opened.
+ */
+bool PerfCounters_available(PerfCounters* this);
+
+/*
+ * Resets and enables all available counters.
+ */
+void PerfCounters_start(PerfCounters* this);
+
+/*
+ * Disables all available counters and records their values.
+ */
+void PerfCounters_stop(PerfCounters* this);
+
+/*
+ * Returns true if the given counter was recorded by the last PerfCounters_stop.
+ * On success the recorded value, scaled if the counter was multiplexed, is stored in *value.
+ */
+bool PerfCounters_get(PerfCounters* this, PerfCounterId id, uint64_t* value);
+
+/*
+ * Prints the recorded counters divided by ops, prefixed with label.
+ * Unavailable counters are printed as n/a and scaled ones are followed by a *.
+ */
+void PerfCounters_print(PerfCounters* this, const char* label, long ops);
+
+/*
+ * Destroys these counters by closing the counter descriptors and freeing the memory used.
+ */
+void PerfCounters_destroy(PerfCounters* this);
+
+#endif /* PERF_COUNTERS_H_ */
@@ -0,0 +1,281 @@
+/*
+ * Pipeline.c
+ *
+ * Multi-stage pipeline runtime: worker threads per stage, batched hand-off between stages
+ * over BlockingQueues, end-of-stream propagation and per-stage timing.
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "Pipeline.h"
+
+/*
+ * Marks the end of the stream in a stage's input queue. Only one is ever in a queue:
+ * each worker that takes it puts it back for its siblings, and the last one to exit
+ * passes it on to the next stage.
+ */
+static char endOfStream;
+
+/*
+ * Returns the current monotonic time in nanoseconds.
+ */
+static uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+/*
+ * Worker thread of one stage.
+ */
+static void *runStage(void *arg) {
+    PipelineStage *stage = (PipelineStage *) arg;
+    Pipeline *pipeline = stage->pipeline;
+    PipelineStage *next = stage->index + 1 < pipeline->numStages ? &(pipeline->stages[stage->index + 1]) : NULL;
+    size_t batchSize = pipeline->batchSize;
+    void *fallback[2];
+    void **input = (void **) malloc(sizeof(void *) * batchSize);
+    void **output = (void **) malloc(sizeof(void *) * batchSize);
+    bool buffered = input != NULL && output != NULL;
+    if (!buffered) {
+        /* Without buffers, move one element at a time through the stage. */
+        free(input);
+        free(output);
+        input = &fallback[0];
+        output = &fallback[1];
+        batchSize = 1;
+    }
+
+    bool end = false;
+    while (!end) {
+        uint64_t start = nowNs();
+        size_t count = BlockingQueue_deqBatch(stage->input, input, batchSize);
+        uint64_t taken = nowNs();
+
+        size_t produced = 0;
+        size_t processed = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (input[i] == &endOfStream) {
+                end = true;
+                break;
+            }
+            void *result = stage->function(input[i], stage->arg);
+            processed++;
+            if (result != NULL && next != NULL) {
+                output[produced++] = result;
+            }
+        }
+        uint64_t done = nowNs();
+
+        if (produced > 0) {
+            BlockingQueue_enqBatch(next->input, output, produced);
+        }
+        uint64_t published = nowNs();
+
+        atomic_fetch_add_explicit(&(stage->processed), processed, memory_order_relaxed);
+        atomic_fetch_add_explicit(&(stage->batches), 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&(stage->waitNs), taken - start, memory_order_relaxed);
+        atomic_fetch_add_explicit(&(stage->busyNs), done - taken, memory_order_relaxed);
+        atomic_fetch_add_explicit(&(stage->blockedNs), published - done, memory_order_relaxed);
+    }
+
+    if (atomic_fetch_sub(&(stage->running), 1) > 1) {
+        BlockingQueue_enq(stage->input, &endOfStream);
+    } else if (next != NULL) {
+        BlockingQueue_enq(next->input, &endOfStream);
+    }
+
+    if (buffered) {
+        free(input);
+        free(output);
+    }
+    return NULL;
+}
+
+Pipeline *new_Pipeline(size_t batch_size) {
+    if (batch_size == 0) {
+        return NULL;
+    }
+
+    Pipeline* pipeline = (Pipeline*) malloc(sizeof(Pipeline));
+    if (pipeline == NULL) {
+        return NULL;
+    }
+
+    pipeline->batchSize = batch_size;
+    pipeline->numStages = 0;
+    pipeline->started = false;
+    pipeline->closed = false;
+    pipeline->startNs = 0;
+    pipeline->stopNs = 0;
+
+    return pipeline;
+}
+
+int Pipeline_addStage(Pipeline* this, const char* name, PipelineStageFunction function, void* arg,
+        int parallelism, size_t queue_capacity) {
+    if (this->started || this->numStages == PIPELINE_MAX_STAGES || function == NULL
+            || parallelism <= 0 || queue_capacity == 0) {
+        return -1;
+    }
+
+    PipelineStage *stage = &(this->stages[this->numStages]);
+    stage->input = new_BlockingQueue(queue_capacity);
+    stage->threads = (pthread_t *) malloc(sizeof(pthread_t) * parallelism);
+    if (stage->input == NULL || stage->threads == NULL) {
+        if (stage->input != NULL) {
+            BlockingQueue_destroy(stage->input);
+        }
+        free(stage->threads);
+        return -1;
+    }
+
+    stage->name = name;
+    stage->function = function;
+    stage->arg = arg;
+    stage->parallelism = parallelism;
+    stage->capacity = queue_capacity;
+    stage->pipeline = this;
+    stage->index = this->numStages;
+    atomic_init(&(stage->running), 0);
+    atomic_init(&(stage->processed), 0);
+    atomic_init(&(stage->batches), 0);
+    atomic_init(&(stage->busyNs), 0);
+    atomic_init(&(stage->waitNs), 0);
+    atomic_init(&(stage->blockedNs), 0);
+
+    return this->numStages++;
+}
+
+bool Pipeline_start(Pipeline* this) {
+    if (this->started || this->numStages == 0) {
+        return false;
+    }
+
+    this->started = true;
+    this->startNs = nowNs();
+    for (int s = 0; s < this->numStages; s++) {
+        PipelineStage *stage = &(this->stages[s]);
+        atomic_store(&(stage->running), stage->parallelism);
+    }
+
+    for (int s = 0; s < this->numStages; s++) {
+        PipelineStage *stage = &(this->stages[s]);
+        for (int w = 0; w < stage->parallelism; w++) {
+            if (pthread_create(&(stage->threads[w]), NULL, runStage, stage) != 0) {
+                /* Shrink every stage to the workers that exist so Pipeline_close can still drain it. */
+                stage->parallelism = w;
+                atomic_store(&(stage->running), w);
+                for (int rest = s + 1; rest < this->numStages; rest++) {
+                    this->stages[rest].parallelism = 0;
+                    atomic_store(&(this->stages[rest].running), 0);
+                }
+                Pipeline_close(this);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool Pipeline_submit(Pipeline* this, void* element) {
+    if (!this->started || this->closed) {
+        return false;
+    }
+    return BlockingQueue_enq(this->stages[0].input, element);
+}
+
+size_t Pipeline_submitBatch(Pipeline* this, void** elements, size_t count) {
+    if (!this->started || this->closed) {
+        return 0;
+    }
+    return BlockingQueue_enqBatch(this->stages[0].input, elements, count);
+}
+
+void Pipeline_close(Pipeline* this) {
+    if (!this->started || this->closed) {
+        return;
+    }
+    this->closed = true;
+
+    /* A stage left without workers by a failed start ends the stream there. */
+    if (this->stages[0].parallelism > 0) {
+        BlockingQueue_enq(this->stages[0].input, &endOfStream);
+    }
+    for (int s = 0; s < this->numStages; s++) {
+        PipelineStage *stage = &(this->stages[s]);
+        for (int w = 0; w < stage->parallelism; w++) {
+            pthread_join(stage->threads[w], NULL);
+        }
+    }
+    this->stopNs = nowNs();
+}
+
+bool Pipeline_stats(Pipeline* this, int index, PipelineStageStats* stats) {
+    if (index < 0 || index >= this->numStages) {
+        return false;
+    }
+
+    PipelineStage *stage = &(this->stages[index]);
+    uint64_t elapsedNs = 0;
+    if (this->started) {
+        elapsedNs = (this->stopNs != 0 ? this->stopNs : nowNs()) - this->startNs;
+    }
+    double elapsed = elapsedNs / 1e9;
+
+    stats->name = stage->name;
+    stats->parallelism = stage->parallelism;
+    stats->processed = atomic_load_explicit(&(stage->processed), memory_order_relaxed);
+    stats->batches = atomic_load_explicit(&(stage->batches), memory_order_relaxed);
+    stats->throughput = elapsed > 0 ? stats->processed / elapsed : 0;
+    stats->queueDepth = BlockingQueue_size(stage->input);
+    stats->queueCapacity = stage->capacity;
+    stats->busySeconds = atomic_load_explicit(&(stage->busyNs), memory_order_relaxed) / 1e9;
+    stats->waitSeconds = atomic_load_explicit(&(stage->waitNs), memory_order_relaxed) / 1e9;
+    stats->blockedSeconds = atomic_load_explicit(&(stage->blockedNs), memory_order_relaxed) / 1e9;
+    stats->utilization = elapsed > 0 && stage->parallelism > 0 ? stats->busySeconds / (elapsed * stage->parallelism) : 0;
+
+    return true;
+}
+
+int Pipeline_bottleneck(Pipeline* this) {
+    int slowest = -1;
+    double highest = -1;
+    for (int s = 0; s < this->numStages; s++) {
+        PipelineStageStats stats;
+        Pipeline_stats(this, s, &stats);
+        if (stats.utilization > highest) {
+            highest = stats.utilization;
+            slowest = s;
+        }
+    }
+    return slowest;
+}
+
+void Pipeline_printStats(Pipeline* this) {
+    int slowest = Pipeline_bottleneck(this);
+    for (int s = 0; s < this->numStages; s++) {
+        PipelineStageStats stats;
+        Pipeline_stats(this, s, &stats);
+        printf("  %-16s x%-3d processed=%lu throughput=%.0f/s depth=%zu/%zu busy=%.3fs wait=%.3fs blocked=%.3fs util=%.0f%%%s\n",
+                stats.name != NULL ? stats.name : "?", stats.parallelism, stats.processed, stats.throughput,
+                stats.queueDepth, stats.queueCapacity, stats.busySeconds, stats.waitSeconds, stats.blockedSeconds,
+                stats.utilization * 100, s == slowest ? "  <- bottleneck" : "");
+    }
+}
+
+void Pipeline_destroy(Pipeline* this) {
+    Pipeline_close(this);
+    for (int s = 0; s < this->numStages; s++) {
+        BlockingQueue_destroy(this->stages[s].input);
+        free(this->stages[s].threads);
+    }
+    free(this);
+}
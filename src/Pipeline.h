@@ -0,0 +1,151 @@
+/*
+ * Pipeline.h
+ *
+ * Module interface for a multi-stage processing pipeline over BlockingQueues.
+ *
+ * Each stage has a function, a number of worker threads and a bounded input queue.
+ * Workers take up to batch_size elements from their input queue at a time, run the
+ * function on each, and publish the results to the next stage's queue as one batch.
+ * Closing the pipeline drains every stage in order before its threads exit.
+ *
+ * Per-stage statistics show where time goes: busy time in the stage function, time
+ * waiting for input, time blocked on a full downstream queue, and the current queue depth.
+ * The stage whose workers are busiest relative to their number is the bottleneck.
+ *
+ */
+
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "BlockingQueue.h"
+
+#define PIPELINE_MAX_STAGES 16
+
+typedef struct Pipeline Pipeline;
+
+/*
+ * Processes element, returning the element to pass to the next stage or NULL to pass nothing.
+ * The result of the last stage is discarded. arg is the pointer given to Pipeline_addStage.
+ */
+typedef void* (*PipelineStageFunction)(void* element, void* arg);
+
+typedef struct PipelineStage {
+    const char *name;
+    PipelineStageFunction function;
+    void *arg;
+    int parallelism;
+    size_t capacity;
+    BlockingQueue *input;
+    pthread_t *threads;
+    Pipeline *pipeline;
+    int index;
+    /* Workers that have not yet seen the end of the stream. */
+    atomic_int running;
+    atomic_ulong processed;
+    atomic_ulong batches;
+    atomic_ullong busyNs;
+    atomic_ullong waitNs;
+    atomic_ullong blockedNs;
+} PipelineStage;
+
+struct Pipeline {
+    size_t batchSize;
+    int numStages;
+    bool started;
+    bool closed;
+    uint64_t startNs;
+    uint64_t stopNs;
+    PipelineStage stages[PIPELINE_MAX_STAGES];
+};
+
+/*
+ * Snapshot of one stage's statistics since Pipeline_start.
+ */
+typedef struct PipelineStageStats {
+    const char *name;
+    int parallelism;
+    /* Elements passed to the stage function. */
+    unsigned long processed;
+    /* Batches taken from the input queue. */
+    unsigned long batches;
+    /* Elements processed per second of pipeline run time. */
+    double throughput;
+    size_t queueDepth;
+    size_t queueCapacity;
+    /* Seconds summed over the stage's workers. */
+    double busySeconds;
+    double waitSeconds;
+    double blockedSeconds;
+    /* Fraction of the workers' run time spent in the stage function. */
+    double utilization;
+} PipelineStageStats;
+
+/*
+ * Creates a new, empty Pipeline whose workers move up to batch_size elements at a time.
+ * Returns a pointer to a new Pipeline on success and NULL on failure.
+ */
+Pipeline* new_Pipeline(size_t batch_size);
+
+/*
+ * Appends a stage running function with arg on parallelism worker threads, fed by an
+ * input queue of queue_capacity elements. name is kept by reference for statistics.
+ * Stages must be added before Pipeline_start.
+ * Returns the index of the new stage, or -1 if the pipeline has started, is full or the queue cannot be created.
+ */
+int Pipeline_addStage(Pipeline* this, const char* name, PipelineStageFunction function, void* arg,
+        int parallelism, size_t queue_capacity);
+
+/*
+ * Starts the worker threads of every stage.
+ * Returns false if there are no stages, the pipeline was already started, or a thread cannot be created.
+ */
+bool Pipeline_start(Pipeline* this);
+
+/*
+ * Submits the given element to the first stage, blocking while its queue is full.
+ * May be called from several threads, but not after Pipeline_close.
+ * Returns false when element is NULL or the pipeline is not running, and true on success.
+ */
+bool Pipeline_submit(Pipeline* this, void* element);
+
+/*
+ * Submits count elements to the first stage like Pipeline_submit, taking its queue's lock once per batch.
+ * Returns the number of elements submitted; NULL elements are skipped.
+ */
+size_t Pipeline_submitBatch(Pipeline* this, void** elements, size_t count);
+
+/*
+ * Ends the stream: every element already submitted passes through the remaining stages,
+ * then each stage's workers exit once the stage before them has finished.
+ * Blocks until all worker threads have exited.
+ */
+void Pipeline_close(Pipeline* this);
+
+/*
+ * Fills stats with the statistics of the stage at index.
+ * Returns false if there is no such stage.
+ */
+bool Pipeline_stats(Pipeline* this, int index, PipelineStageStats* stats);
+
+/*
+ * Returns the index of the stage with the highest utilization, or -1 if there are no stages.
+ */
+int Pipeline_bottleneck(Pipeline* this);
+
+/*
+ * Prints one line of statistics per stage, marking the bottleneck.
+ */
+void Pipeline_printStats(Pipeline* this);
+
+/*
+ * Closes this Pipeline if it is running and destroys it by freeing the memory used.
+ */
+void Pipeline_destroy(Pipeline* this);
+
+#endif /* PIPELINE_H_ */
@@ -6,9 +6,12 @@
  */
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include "Queue.h"
+#include "QueueInline.h"
+#include "ReservedRing.h"
 
 /*
  * The functions below all return default values and don't work.
@@ -16,64 +19,71 @@
  */
 
 
-Queue *new_Queue(int max_size) {
+/*
+ * Creates the Queue, allocating its slots on the heap or as reserved address space.
+ */
+static Queue *createQueue(size_t max_size, bool reserved) {
+    if (max_size > SIZE_MAX / sizeof(void*)) {
+        return NULL;
+    }
+
     Queue* queue = (Queue*) malloc(sizeof(Queue));
     if (queue == NULL) {
         free(queue);
         return NULL;
     }
 
-    queue->array = malloc(sizeof(void*) * max_size);
+    queue->array = reserved ? ReservedRing_reserve(max_size) : malloc(sizeof(void*) * max_size);
     if (queue->array == NULL) {
-        free(queue->array);
+        free(queue);
         return NULL;
     }
 
     queue->maxSize = max_size;
     queue->size = 0;
+    queue->head = 0;
+    queue->reserved = reserved;
 
     return queue;
 }
 
+Queue *new_Queue(size_t max_size) {
+    return createQueue(max_size, false);
+}
+
+Queue *new_QueueReserved(size_t max_size) {
+    return createQueue(max_size, true);
+}
+
 bool Queue_enq(Queue* this, void* element) {
-    if (this->size == this->maxSize) {
-        return false;
-    } else if (element == NULL) {
-        return false;
-    } else {
-        this->array[this->size] = element;
-        this->size++;
-    }
-    return true;
+    return QueueInline_enq(this, element);
 }
 
 void* Queue_deq(Queue* this) {
-    void* data;
-    if (this->size == 0) {
-        data = NULL;
-    } else {
-        data = this->array[0];
-        for (int i = 1; i < this->size; i++) {
-            this->array[i - 1] = this->array[i];
-        }
-        this->size--;
-    }
-    return data;
+    return QueueInline_deq(this);
 }
 
-int Queue_size(Queue* this) {
-    return this->size;
+size_t Queue_size(Queue* this) {
+    return QueueInline_size(this);
 }
 
 bool Queue_isEmpty(Queue* this) {
-    return this->size == 0;
+    return QueueInline_isEmpty(this);
 }
 
 void Queue_clear(Queue* this) {
     this->size = 0;
+    this->head = 0;
+    if (this->reserved) {
+        ReservedRing_releaseAll(this->array, this->maxSize);
+    }
 }
 
 void Queue_destroy(Queue* this) {
-    free(this->array);
+    if (this->reserved) {
+        ReservedRing_free(this->array, this->maxSize);
+    } else {
+        free(this->array);
+    }
     free(this);
 }
@@ -9,52 +9,71 @@
 #define QUEUE_H_
 
 #include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef struct Queue Queue;
 
 /* You should define your struct Queue here */
 struct Queue {
     void **array;
-    int maxSize;
-    int size;
+    size_t maxSize;
+    size_t size;
+    size_t head;
+    bool reserved;
 };
 
 /*
  * Creates a new Queue for at most max_size void* elements.
  * Returns a pointer to a new Queue on success and NULL on failure.
  */
-Queue* new_Queue(int max_size);
+Queue* new_Queue(size_t max_size);
+
+/*
+ * Creates a new Queue for at most max_size void* elements whose storage is reserved
+ * address space, committed only as occupancy reaches it and released as it drains.
+ * Suitable for capacities of billions of elements used as a safety margin.
+ * Returns a pointer to a new Queue on success and NULL on failure.
+ */
+Queue* new_QueueReserved(size_t max_size);
 
 /*
  * Enqueues the given void* element at the back of this Queue.
  * Returns true on success and false on enq failure when element is NULL or queue is full.
  */
-bool Queue_enq(Queue* this, void* element);
+bool Queue_enq(Queue* queue, void* element);
 
 /*
  * Dequeues an element from the front of this Queue.
  * Returns dequeued void* element on success or NULL if queue is empty.
  */
-void* Queue_deq(Queue* this);
+void* Queue_deq(Queue* queue);
 
 /*
  * Returns the number of elements currently in this Queue.
  */
-int Queue_size(Queue* this);
+size_t Queue_size(Queue* queue);
 
 /*
  * Returns true if this Queue is empty, false otherwise.
  */
-bool Queue_isEmpty(Queue* this);
+bool Queue_isEmpty(Queue* queue);
 
 /*
  * Clears this Queue returning it to an empty state.
  */
-void Queue_clear(Queue* this);
+void Queue_clear(Queue* queue);
 
 /*
  * Destroys this Queue by freeing the memory used by the Queue.
  */
-void Queue_destroy(Queue* this);
+void Queue_destroy(Queue* queue);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* QUEUE_H_ */
@@ -0,0 +1,77 @@
+/*
+ * QueueInline.h
+ *
+ * Opt-in header-only fast path for the hot Queue operations.
+ *
+ * The functions below operate on the same struct Queue as Queue.c and have exactly
+ * the semantics documented in Queue.h, but are static inline so the compiler can
+ * optimise through them at the call site. Queue.c is implemented in terms of these
+ * functions, so the out-of-line symbols in Queue.o remain available and unchanged.
+ *
+ * Define QUEUE_USE_INLINE before including this header to have calls to Queue_enq,
+ * Queue_deq, Queue_size and Queue_isEmpty resolve to the inline versions.
+ *
+ */
+
+#ifndef QUEUE_INLINE_H_
+#define QUEUE_INLINE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "Queue.h"
+#include "ReservedRing.h"
+
+/*
+ * Inline version of Queue_enq.
+ * Returns true on success and false on enq failure when element is NULL or queue is full.
+ */
+static inline bool QueueInline_enq(Queue* this, void* element) {
+    if (this->size == this->maxSize || element == NULL) {
+        return false;
+    }
+    size_t tail = this->head + this->size;
+    this->array[tail >= this->maxSize ? tail - this->maxSize : tail] = element;
+    this->size++;
+    return true;
+}
+
+/*
+ * Inline version of Queue_deq.
+ * Returns dequeued void* element on success or NULL if queue is empty.
+ */
+static inline void* QueueInline_deq(Queue* this) {
+    if (this->size == 0) {
+        return NULL;
+    }
+    void* data = this->array[this->head];
+    this->head = (this->head + 1 == this->maxSize) ? 0 : this->head + 1;
+    this->size--;
+    if (this->reserved) {
+        ReservedRing_advanced(this->array, this->maxSize, this->head, this->size);
+    }
+    return data;
+}
+
+/*
+ * Inline version of Queue_size.
+ */
+static inline size_t QueueInline_size(const Queue* this) {
+    return this->size;
+}
+
+/*
+ * Inline version of Queue_isEmpty.
+ */
+static inline bool QueueInline_isEmpty(const Queue* this) {
+    return this->size == 0;
+}
+
+#ifdef QUEUE_USE_INLINE
+#define Queue_enq(this, element) QueueInline_enq((this), (element))
+#define Queue_deq(this) QueueInline_deq(this)
+#define Queue_size(this) QueueInline_size(this)
+#define Queue_isEmpty(this) QueueInline_isEmpty(this)
+#endif /* QUEUE_USE_INLINE */
+
+#endif /* QUEUE_INLINE_H_ */
@@ -0,0 +1,274 @@
+/*
+ * QueueReplay.c
+ *
+ * Re-drives a recorded queue trace with one thread per traced thread and measures the result.
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "QueueReplay.h"
+
+/*
+ * Gaps at least this long are slept through; shorter ones are spun so they stay accurate.
+ */
+#define SLEEP_THRESHOLD_NS 100000
+
+/*
+ * Placeholder element carried by replayed enqueues.
+ */
+#define REPLAY_ELEMENT ((void *) 1)
+
+/*
+ * One operation of a replay thread: the queue, enq or deq, and the pause before it.
+ */
+typedef struct ReplayOp {
+    uint32_t queue;
+    uint32_t type;
+    uint64_t delayNs;
+} ReplayOp;
+
+/*
+ * Releases the replay threads together once all exist, or sends them home if one could not be created.
+ */
+typedef struct ReplayStart {
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    /* 0 while threads are being created, 1 to run, -1 to exit without running. */
+    int state;
+} ReplayStart;
+
+/*
+ * Operations and measurements of one replay thread.
+ */
+typedef struct ReplayThread {
+    ReplayOp *ops;
+    size_t count;
+    uint64_t *latencies;
+    void **queues;
+    const QueueReplayOps *queueOps;
+    bool thinkTime;
+    ReplayStart *start;
+    uint64_t startNs;
+    uint64_t endNs;
+    /* Trace bookkeeping while the operations are built. */
+    uint64_t lastNs;
+    uint64_t blockedNs;
+} ReplayThread;
+
+/*
+ * Returns the current monotonic time in nanoseconds.
+ */
+static uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+/*
+ * Waits for delay nanoseconds.
+ */
+static void waitNs(uint64_t delay) {
+    uint64_t deadline = nowNs() + delay;
+    if (delay >= SLEEP_THRESHOLD_NS) {
+        struct timespec ts = { (time_t) (delay / 1000000000u), (long) (delay % 1000000000u) };
+        nanosleep(&ts, NULL);
+    }
+    while (nowNs() < deadline) {
+    }
+}
+
+/*
+ * Returns the index of value in the first *used entries of ids, appending it if it is new.
+ * Returns -1 if it is new and ids already holds limit entries.
+ */
+static int indexOf(uint64_t *ids, int *used, int limit, uint64_t value) {
+    for (int i = 0; i < *used; i++) {
+        if (ids[i] == value) {
+            return i;
+        }
+    }
+    if (*used == limit) {
+        return -1;
+    }
+    ids[*used] = value;
+    return (*used)++;
+}
+
+static int compareLatencies(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/*
+ * Replay thread: waits for every thread to be created, then performs its operations.
+ */
+static void *replayThread(void *arg) {
+    ReplayThread *thread = (ReplayThread *) arg;
+    pthread_mutex_lock(&(thread->start->mutex));
+    while (thread->start->state == 0) {
+        pthread_cond_wait(&(thread->start->changed), &(thread->start->mutex));
+    }
+    int state = thread->start->state;
+    pthread_mutex_unlock(&(thread->start->mutex));
+    if (state < 0) {
+        return NULL;
+    }
+
+    thread->startNs = nowNs();
+    for (size_t i = 0; i < thread->count; i++) {
+        ReplayOp *op = &(thread->ops[i]);
+        if (thread->thinkTime && op->delayNs > 0) {
+            waitNs(op->delayNs);
+        }
+        void *queue = thread->queues[op->queue];
+        uint64_t start = nowNs();
+        if (op->type == QUEUE_TRACE_ENQ) {
+            thread->queueOps->enq(queue, REPLAY_ELEMENT);
+        } else {
+            thread->queueOps->deq(queue);
+        }
+        thread->latencies[i] = nowNs() - start;
+    }
+    thread->endNs = nowNs();
+
+    return NULL;
+}
+
+bool QueueReplay_run(const QueueTraceEvent* events, size_t count, const QueueReplayOps* ops, size_t capacity,
+        bool think_time, QueueReplayResult* result) {
+    uint64_t queueIds[QUEUE_REPLAY_MAX_QUEUES];
+    uint64_t threadIds[QUEUE_REPLAY_MAX_THREADS];
+    size_t opCounts[QUEUE_REPLAY_MAX_THREADS] = {0};
+    int numQueues = 0;
+    int numThreads = 0;
+    size_t total = 0;
+
+    /* First pass: number the queues and threads and count each thread's operations. */
+    for (size_t i = 0; i < count; i++) {
+        int t = indexOf(threadIds, &numThreads, QUEUE_REPLAY_MAX_THREADS, events[i].thread);
+        if (t < 0 || indexOf(queueIds, &numQueues, QUEUE_REPLAY_MAX_QUEUES, events[i].queue) < 0) {
+            return false;
+        }
+        if (events[i].type == QUEUE_TRACE_ENQ || events[i].type == QUEUE_TRACE_DEQ) {
+            opCounts[t]++;
+            total++;
+        }
+    }
+    if (total == 0) {
+        return false;
+    }
+
+    ReplayThread *threads = (ReplayThread *) calloc(numThreads, sizeof(ReplayThread));
+    pthread_t *handles = (pthread_t *) malloc(sizeof(pthread_t) * numThreads);
+    void **queues = (void **) calloc(numQueues, sizeof(void *));
+    uint64_t *latencies = (uint64_t *) malloc(sizeof(uint64_t) * total);
+    bool ok = threads != NULL && handles != NULL && queues != NULL && latencies != NULL;
+
+    /* Second pass: build each thread's operations and track every queue's depth. */
+    long depth[QUEUE_REPLAY_MAX_QUEUES] = {0};
+    long lowest[QUEUE_REPLAY_MAX_QUEUES] = {0};
+    size_t offset = 0;
+    for (int t = 0; ok && t < numThreads; t++) {
+        threads[t].ops = (ReplayOp *) malloc(sizeof(ReplayOp) * (opCounts[t] > 0 ? opCounts[t] : 1));
+        threads[t].latencies = latencies + offset;
+        offset += opCounts[t];
+        ok = threads[t].ops != NULL;
+    }
+    for (size_t i = 0; ok && i < count; i++) {
+        const QueueTraceEvent *event = &(events[i]);
+        int t = indexOf(threadIds, &numThreads, QUEUE_REPLAY_MAX_THREADS, event->thread);
+        int q = indexOf(queueIds, &numQueues, QUEUE_REPLAY_MAX_QUEUES, event->queue);
+        ReplayThread *thread = &(threads[t]);
+
+        if (event->type == QUEUE_TRACE_BLOCK_ENQ || event->type == QUEUE_TRACE_BLOCK_DEQ) {
+            thread->blockedNs = event->timestampNs;
+            continue;
+        }
+
+        uint64_t began = thread->blockedNs != 0 ? thread->blockedNs : event->timestampNs;
+        ReplayOp *op = &(thread->ops[thread->count++]);
+        op->queue = (uint32_t) q;
+        op->type = event->type;
+        op->delayNs = thread->lastNs != 0 && began > thread->lastNs ? began - thread->lastNs : 0;
+        thread->lastNs = event->timestampNs;
+        thread->blockedNs = 0;
+
+        depth[q] += event->type == QUEUE_TRACE_ENQ ? 1 : -1;
+        lowest[q] = depth[q] < lowest[q] ? depth[q] : lowest[q];
+    }
+
+    /* Pre-fill each queue with the elements the trace dequeued before enqueuing them. */
+    for (int q = 0; ok && q < numQueues; q++) {
+        size_t prefill = (size_t) -lowest[q];
+        size_t remaining = (size_t) (depth[q] - lowest[q]);
+        size_t size = capacity;
+        size = prefill > size ? prefill : size;
+        size = remaining > size ? remaining : size;
+        queues[q] = ops->create(size > 0 ? size : 1);
+        ok = queues[q] != NULL;
+        for (size_t i = 0; ok && i < prefill; i++) {
+            ops->enq(queues[q], REPLAY_ELEMENT);
+        }
+    }
+
+    ReplayStart start = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0 };
+    int started = 0;
+    for (; ok && started < numThreads; started++) {
+        threads[started].queues = queues;
+        threads[started].queueOps = ops;
+        threads[started].thinkTime = think_time;
+        threads[started].start = &start;
+        ok = pthread_create(&(handles[started]), NULL, replayThread, &(threads[started])) == 0;
+    }
+    if (!ok) {
+        started--;
+    }
+
+    pthread_mutex_lock(&(start.mutex));
+    start.state = ok ? 1 : -1;
+    pthread_cond_broadcast(&(start.changed));
+    pthread_mutex_unlock(&(start.mutex));
+    for (int t = 0; t < started; t++) {
+        pthread_join(handles[t], NULL);
+    }
+
+    if (ok) {
+        uint64_t first = UINT64_MAX;
+        uint64_t last = 0;
+        for (int t = 0; t < numThreads; t++) {
+            first = threads[t].startNs < first ? threads[t].startNs : first;
+            last = threads[t].endNs > last ? threads[t].endNs : last;
+        }
+        qsort(latencies, total, sizeof(uint64_t), compareLatencies);
+
+        result->operations = (long) total;
+        result->threads = numThreads;
+        result->queues = numQueues;
+        result->seconds = (last - first) / 1e9;
+        result->throughput = result->seconds > 0 ? total / result->seconds : 0;
+        result->latencyP50Ns = (double) latencies[total / 2];
+        result->latencyP99Ns = (double) latencies[total - 1 - total / 100];
+        result->latencyMaxNs = (double) latencies[total - 1];
+    }
+
+    for (int q = 0; queues != NULL && q < numQueues; q++) {
+        if (queues[q] != NULL) {
+            ops->destroy(queues[q]);
+        }
+    }
+    for (int t = 0; threads != NULL && t < numThreads; t++) {
+        free(threads[t].ops);
+    }
+    free(threads);
+    free(handles);
+    free(queues);
+    free(latencies);
+
+    return ok;
+}
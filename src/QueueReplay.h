@@ -0,0 +1,63 @@
+/*
+ * QueueReplay.h
+ *
+ * Module interface for replaying a recorded QueueTrace against any queue implementation.
+ *
+ * Each traced thread becomes a replay thread performing the same sequence of enqueues and
+ * dequeues on the same queues. With think time enabled, a thread pauses between operations
+ * for as long as the traced thread spent outside the queue, so bursts and idle periods keep
+ * their shape; time the traced thread spent blocked is not replayed but left to the queue
+ * under test. Each queue is pre-filled with enough elements that no dequeue the trace
+ * satisfied waits forever, and is made large enough to hold everything left at the end.
+ *
+ */
+
+#ifndef QUEUE_REPLAY_H_
+#define QUEUE_REPLAY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "QueueTrace.h"
+
+/*
+ * Most distinct queues and threads a replayed trace may contain.
+ */
+#define QUEUE_REPLAY_MAX_QUEUES 64
+#define QUEUE_REPLAY_MAX_THREADS 256
+
+/*
+ * Operations of one queue implementation to replay against.
+ */
+typedef struct QueueReplayOps {
+    const char *name;
+    void *(*create)(size_t max_size);
+    bool (*enq)(void *queue, void *element);
+    void *(*deq)(void *queue);
+    void (*destroy)(void *queue);
+} QueueReplayOps;
+
+typedef struct QueueReplayResult {
+    /* Enqueues and dequeues performed. */
+    long operations;
+    int threads;
+    int queues;
+    /* Wall-clock time from the first replay thread starting to the last one finishing. */
+    double seconds;
+    double throughput;
+    /* Time spent inside individual enq and deq calls. */
+    double latencyP50Ns;
+    double latencyP99Ns;
+    double latencyMaxNs;
+} QueueReplayResult;
+
+/*
+ * Replays count events against queues created through ops with at least capacity slots each.
+ * think_time selects whether the gaps between each thread's operations are reproduced.
+ * Returns false, leaving result unset, if the trace has no operations, too many threads or
+ * queues, or memory or threads cannot be allocated.
+ */
+bool QueueReplay_run(const QueueTraceEvent* events, size_t count, const QueueReplayOps* ops, size_t capacity,
+        bool think_time, QueueReplayResult* result);
+
+#endif /* QUEUE_REPLAY_H_ */
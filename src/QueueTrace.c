@@ -0,0 +1,237 @@
+/*
+ * QueueTrace.c
+ *
+ * Per-thread buffered recording of queue operations, merged and persisted on demand.
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "QueueTrace.h"
+
+/*
+ * Identifies trace files and their layout: magic, version, event count, then the events.
+ */
+#define TRACE_FILE_MAGIC 0x43525451u
+#define TRACE_FILE_VERSION 1u
+
+/*
+ * A run of events recorded by one thread.
+ */
+typedef struct TraceChunk {
+    struct TraceChunk *next;
+    size_t count;
+    QueueTraceEvent events[QUEUE_TRACE_CHUNK_EVENTS];
+} TraceChunk;
+
+/*
+ * Event with its position in the unsorted trace, used to keep the merge stable.
+ */
+typedef struct OrderedEvent {
+    QueueTraceEvent event;
+    size_t order;
+} OrderedEvent;
+
+atomic_bool queueTraceEnabled = false;
+
+/*
+ * Every chunk of the current trace in allocation order, so each thread's chunks are in
+ * recording order. generation changes on QueueTrace_start to retire threads' chunks.
+ */
+static struct {
+    pthread_mutex_t mutex;
+    TraceChunk *head;
+    TraceChunk *tail;
+    atomic_uint generation;
+    uint32_t nextThread;
+} trace = { PTHREAD_MUTEX_INITIALIZER, NULL, NULL, 0, 0 };
+
+/*
+ * The calling thread's current chunk, the trace generation it belongs to and the thread's id in it.
+ */
+static __thread TraceChunk *current;
+static __thread unsigned currentGeneration;
+static __thread uint32_t currentThread;
+
+/*
+ * Returns the current monotonic time in nanoseconds.
+ */
+static uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+/*
+ * Gives the calling thread a new chunk in the given generation, numbering the thread
+ * if it has not recorded in that generation yet. Returns false if allocation fails.
+ */
+static bool nextChunk(unsigned generation) {
+    TraceChunk *chunk = (TraceChunk *) malloc(sizeof(TraceChunk));
+    if (chunk == NULL) {
+        return false;
+    }
+    chunk->next = NULL;
+    chunk->count = 0;
+
+    pthread_mutex_lock(&(trace.mutex));
+    if (generation != atomic_load(&(trace.generation))) {
+        /* QueueTrace_start ran meanwhile; record into the new trace next time. */
+        pthread_mutex_unlock(&(trace.mutex));
+        free(chunk);
+        return false;
+    }
+    if (current == NULL || currentGeneration != generation) {
+        currentThread = trace.nextThread++;
+        currentGeneration = generation;
+    }
+    if (trace.tail == NULL) {
+        trace.head = chunk;
+    } else {
+        trace.tail->next = chunk;
+    }
+    trace.tail = chunk;
+    pthread_mutex_unlock(&(trace.mutex));
+
+    current = chunk;
+    return true;
+}
+
+/*
+ * Orders events by timestamp, then by their position in the unsorted trace.
+ */
+static int compareEvents(const void *a, const void *b) {
+    const OrderedEvent *x = (const OrderedEvent *) a;
+    const OrderedEvent *y = (const OrderedEvent *) b;
+    if (x->event.timestampNs != y->event.timestampNs) {
+        return x->event.timestampNs < y->event.timestampNs ? -1 : 1;
+    }
+    return x->order < y->order ? -1 : (x->order > y->order ? 1 : 0);
+}
+
+void QueueTrace_start() {
+    pthread_mutex_lock(&(trace.mutex));
+    TraceChunk *chunk = trace.head;
+    while (chunk != NULL) {
+        TraceChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    trace.head = NULL;
+    trace.tail = NULL;
+    trace.nextThread = 0;
+    atomic_fetch_add(&(trace.generation), 1);
+    pthread_mutex_unlock(&(trace.mutex));
+
+    atomic_store(&queueTraceEnabled, true);
+}
+
+void QueueTrace_stop() {
+    atomic_store(&queueTraceEnabled, false);
+}
+
+void QueueTrace_record(const void* queue, QueueTraceType type) {
+    if (!QueueTrace_enabled()) {
+        return;
+    }
+
+    unsigned generation = atomic_load_explicit(&(trace.generation), memory_order_relaxed);
+    if (current == NULL || currentGeneration != generation || current->count == QUEUE_TRACE_CHUNK_EVENTS) {
+        if (!nextChunk(generation)) {
+            return;
+        }
+    }
+
+    QueueTraceEvent *event = &(current->events[current->count]);
+    event->timestampNs = nowNs();
+    event->queue = (uint64_t) (uintptr_t) queue;
+    event->thread = currentThread;
+    event->type = type;
+    current->count++;
+}
+
+QueueTraceEvent* QueueTrace_collect(size_t* count) {
+    *count = 0;
+
+    pthread_mutex_lock(&(trace.mutex));
+    size_t total = 0;
+    for (TraceChunk *chunk = trace.head; chunk != NULL; chunk = chunk->next) {
+        total += chunk->count;
+    }
+
+    OrderedEvent *ordered = total > 0 ? (OrderedEvent *) malloc(sizeof(OrderedEvent) * total) : NULL;
+    QueueTraceEvent *events = total > 0 ? (QueueTraceEvent *) malloc(sizeof(QueueTraceEvent) * total) : NULL;
+    if (ordered == NULL || events == NULL) {
+        pthread_mutex_unlock(&(trace.mutex));
+        free(ordered);
+        free(events);
+        return NULL;
+    }
+
+    size_t next = 0;
+    for (TraceChunk *chunk = trace.head; chunk != NULL; chunk = chunk->next) {
+        for (size_t i = 0; i < chunk->count; i++) {
+            ordered[next].event = chunk->events[i];
+            ordered[next].order = next;
+            next++;
+        }
+    }
+    pthread_mutex_unlock(&(trace.mutex));
+
+    qsort(ordered, total, sizeof(OrderedEvent), compareEvents);
+    for (size_t i = 0; i < total; i++) {
+        events[i] = ordered[i].event;
+    }
+    free(ordered);
+
+    *count = total;
+    return events;
+}
+
+bool QueueTrace_save(const char* path, const QueueTraceEvent* events, size_t count) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+
+    uint32_t header[2] = { TRACE_FILE_MAGIC, TRACE_FILE_VERSION };
+    uint64_t length = count;
+    bool written = fwrite(header, sizeof(header), 1, file) == 1
+            && fwrite(&length, sizeof(length), 1, file) == 1
+            && (count == 0 || fwrite(events, sizeof(QueueTraceEvent), count, file) == count);
+
+    return fclose(file) == 0 && written;
+}
+
+QueueTraceEvent* QueueTrace_load(const char* path, size_t* count) {
+    *count = 0;
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    uint32_t header[2];
+    uint64_t length;
+    if (fread(header, sizeof(header), 1, file) != 1 || header[0] != TRACE_FILE_MAGIC
+            || header[1] != TRACE_FILE_VERSION || fread(&length, sizeof(length), 1, file) != 1
+            || length == 0 || length > SIZE_MAX / sizeof(QueueTraceEvent)) {
+        fclose(file);
+        return NULL;
+    }
+
+    QueueTraceEvent *events = (QueueTraceEvent *) malloc(sizeof(QueueTraceEvent) * length);
+    if (events == NULL || fread(events, sizeof(QueueTraceEvent), length, file) != length) {
+        free(events);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+
+    *count = length;
+    return events;
+}
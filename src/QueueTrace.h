@@ -0,0 +1,99 @@
+/*
+ * QueueTrace.h
+ *
+ * Module interface for an opt-in recorder of BlockingQueue operations.
+ *
+ * While tracing is started, every enqueue and dequeue on a BlockingQueue, and every time
+ * one has to block for space or for an element, is recorded with a timestamp and a small
+ * per-thread id. Events go to buffers owned by the recording thread, so threads never
+ * contend while tracing; when tracing is stopped the hooks cost one relaxed atomic load.
+ * Elements removed by BlockingQueue_clear or evicted by an overflow policy are not dequeues
+ * and are not recorded, so a replay only repeats what producers and consumers did.
+ * A collected trace can be saved, loaded and replayed with QueueReplay.
+ *
+ */
+
+#ifndef QUEUE_TRACE_H_
+#define QUEUE_TRACE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+/*
+ * Number of events in each per-thread buffer chunk.
+ */
+#define QUEUE_TRACE_CHUNK_EVENTS 4096
+
+typedef enum QueueTraceType {
+    /* An element was enqueued. */
+    QUEUE_TRACE_ENQ,
+    /* An element was dequeued. */
+    QUEUE_TRACE_DEQ,
+    /* An enqueue found the queue full and started waiting. */
+    QUEUE_TRACE_BLOCK_ENQ,
+    /* A dequeue found the queue empty and started waiting. */
+    QUEUE_TRACE_BLOCK_DEQ
+} QueueTraceType;
+
+typedef struct QueueTraceEvent {
+    /* CLOCK_MONOTONIC time of the event in nanoseconds. */
+    uint64_t timestampNs;
+    /* Identifies the queue; events of one queue share the value. */
+    uint64_t queue;
+    /* Id of the recording thread, numbered from 0 in the order threads first recorded. */
+    uint32_t thread;
+    uint32_t type;
+} QueueTraceEvent;
+
+/*
+ * True while tracing is started. Read through QueueTrace_enabled.
+ */
+extern atomic_bool queueTraceEnabled;
+
+/*
+ * Returns true if operations should currently be recorded.
+ */
+static inline bool QueueTrace_enabled() {
+    return atomic_load_explicit(&queueTraceEnabled, memory_order_relaxed);
+}
+
+/*
+ * Discards any previous trace and starts recording.
+ * No thread may be recording an event while this is called.
+ */
+void QueueTrace_start();
+
+/*
+ * Stops recording. Events already recorded are kept until the next QueueTrace_start.
+ */
+void QueueTrace_stop();
+
+/*
+ * Records an event of the given type on queue for the calling thread.
+ * Does nothing if tracing is stopped or no buffer can be allocated.
+ */
+void QueueTrace_record(const void* queue, QueueTraceType type);
+
+/*
+ * Merges the events recorded since QueueTrace_start into one array ordered by timestamp,
+ * keeping each thread's events in the order it recorded them, and stores its length in *count.
+ * Must be called after QueueTrace_stop, once the traced threads have finished their operations.
+ * Returns the array, which the caller frees, or NULL if there are no events or on failure.
+ */
+QueueTraceEvent* QueueTrace_collect(size_t* count);
+
+/*
+ * Writes count events to the file at path.
+ * Returns true on success and false on failure.
+ */
+bool QueueTrace_save(const char* path, const QueueTraceEvent* events, size_t count);
+
+/*
+ * Reads a trace written by QueueTrace_save, storing its length in *count.
+ * Returns the events, which the caller frees, or NULL if the file is missing, malformed or empty.
+ */
+QueueTraceEvent* QueueTrace_load(const char* path, size_t* count);
+
+#endif /* QUEUE_TRACE_H_ */
@@ -0,0 +1,84 @@
+/*
+ * ReservedRing.c
+ *
+ * mmap-reserved, lazily committed ring buffer storage.
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "ReservedRing.h"
+
+/*
+ * Returns the size in bytes of the mapping backing max_size slots, rounded up to whole pages.
+ */
+static size_t mappingBytes(size_t max_size) {
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    return (max_size * sizeof(void*) + page - 1) / page * page;
+}
+
+void** ReservedRing_reserve(size_t max_size) {
+    if (max_size == 0 || max_size > SIZE_MAX / sizeof(void*)) {
+        return NULL;
+    }
+
+    void *base = mmap(NULL, mappingBytes(max_size), PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+    return (void**) base;
+}
+
+void ReservedRing_releaseBefore(void** array, size_t max_size, size_t head, size_t size) {
+    /* The batch that just emptied is the one before head, or the partial last batch after a wrap. */
+    size_t start = head == 0 ? (max_size - 1) / RESERVED_RING_BATCH_SLOTS * RESERVED_RING_BATCH_SLOTS
+            : head - RESERVED_RING_BATCH_SLOTS;
+    size_t end = head == 0 ? max_size : head;
+
+    /* Live elements occupy [head, head + size) modulo max_size; they must not reach the batch. */
+    if (size > max_size - (end - start)) {
+        return;
+    }
+
+    /* The free slots from the tail up to the batch are filled before the tail re-enters it. */
+    if (max_size - (end - start) - size < RESERVED_RING_RETAIN_SLOTS) {
+        return;
+    }
+
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t from = start * sizeof(void*) / page * page;
+    size_t to = end == max_size ? mappingBytes(max_size) : end * sizeof(void*) / page * page;
+    if (to > from) {
+        madvise((char *) array + from, to - from, MADV_DONTNEED);
+    }
+}
+
+void ReservedRing_releaseAll(void** array, size_t max_size) {
+    madvise(array, mappingBytes(max_size), MADV_DONTNEED);
+}
+
+size_t ReservedRing_residentBytes(void** array, size_t max_size) {
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t pages = mappingBytes(max_size) / page;
+    unsigned char *vec = (unsigned char *) malloc(pages);
+    if (vec == NULL || mincore(array, pages * page, vec) != 0) {
+        free(vec);
+        return 0;
+    }
+
+    size_t resident = 0;
+    for (size_t i = 0; i < pages; i++) {
+        resident += (vec[i] & 1) ? page : 0;
+    }
+    free(vec);
+    return resident;
+}
+
+void ReservedRing_free(void** array, size_t max_size) {
+    munmap(array, mappingBytes(max_size));
+}
@@ -0,0 +1,69 @@
+/*
+ * ReservedRing.h
+ *
+ * Module interface for ring buffer storage that reserves address space up front and only
+ * commits memory for the slots a queue actually occupies.
+ *
+ * The slot array is mapped with mmap but not touched, so pages are only committed when the
+ * tail first writes into them. Whenever the head leaves a batch of RESERVED_RING_BATCH_SLOTS
+ * slots that no longer holds live elements, the batch is returned to the kernel with madvise,
+ * unless the tail will reach it again within RESERVED_RING_RETAIN_SLOTS enqueues. Resident
+ * memory therefore follows the queue's depth rather than its capacity, while a ring cycling
+ * within that window keeps its pages instead of releasing and re-faulting them every lap.
+ *
+ */
+
+#ifndef RESERVED_RING_H_
+#define RESERVED_RING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Number of slots released at a time: 64 KiB of void* slots.
+ */
+#define RESERVED_RING_BATCH_SLOTS ((size_t) 8192)
+
+/*
+ * Free slots ahead of the tail that stay committed: 1 MiB of void* slots.
+ */
+#define RESERVED_RING_RETAIN_SLOTS (16 * RESERVED_RING_BATCH_SLOTS)
+
+/*
+ * Reserves address space for max_size void* slots without committing it.
+ * Returns the slot array on success and NULL on failure.
+ */
+void** ReservedRing_reserve(size_t max_size);
+
+/*
+ * Releases the batch of slots that ends at head. Use ReservedRing_advanced instead.
+ */
+void ReservedRing_releaseBefore(void** array, size_t max_size, size_t head, size_t size);
+
+/*
+ * Releases every committed page of the slot array, for example after the ring was cleared.
+ */
+void ReservedRing_releaseAll(void** array, size_t max_size);
+
+/*
+ * Returns the number of bytes of the slot array currently resident in memory.
+ */
+size_t ReservedRing_residentBytes(void** array, size_t max_size);
+
+/*
+ * Unmaps the slot array reserved for max_size slots.
+ */
+void ReservedRing_free(void** array, size_t max_size);
+
+/*
+ * Called after the head of a ring of max_size slots advanced to head, leaving size live elements.
+ * When the head has just left a batch, releases that batch if it no longer holds live elements
+ * and the tail is more than RESERVED_RING_RETAIN_SLOTS slots away from it.
+ */
+static inline void ReservedRing_advanced(void** array, size_t max_size, size_t head, size_t size) {
+    if (head % RESERVED_RING_BATCH_SLOTS == 0) {
+        ReservedRing_releaseBefore(array, max_size, head, size);
+    }
+}
+
+#endif /* RESERVED_RING_H_ */
@@ -0,0 +1,226 @@
+/*
+ * TestAsyncQueue.cpp
+ *
+ * Very simple unit test file for the coroutine-awaitable typed::AsyncQueue.
+ *
+ */
+
+#include <atomic>
+#include <coroutine>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <thread>
+
+#include "AsyncQueue.hpp"
+#include "myassert.h"
+
+
+#define DEFAULT_MAX_QUEUE_SIZE 16
+#define NUM_CONSUMERS 2000
+#define NUM_THREADS 4
+
+/*
+ * The number of tests that succeeded
+ */
+static int success_count = 0;
+
+/*
+ * The total number of tests run
+ */
+static int total_count = 0;
+
+/*
+ * Coroutine type that starts eagerly and frees its own frame when it finishes.
+ */
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+
+        void return_void() {
+        }
+
+        void unhandled_exception() {
+            std::terminate();
+        }
+    };
+};
+
+/*
+ * This function is called multiple times from main for each user-defined test function
+ */
+void runTest(int (*testFunction)()) {
+    total_count++;
+
+    if (testFunction()) success_count++;
+}
+
+
+Detached consumeOne(typed::AsyncQueue<int>& queue, int& out) {
+    out = co_await queue.pop();
+}
+
+Detached produceAll(typed::AsyncQueue<int>& queue, int first, int last, int& produced) {
+    for (int i = first; i <= last; i++) {
+        co_await queue.push(i);
+        produced = i;
+    }
+}
+
+/*
+ * Checks that pop suspends on an empty queue and that a push resumes the consumer inline.
+ */
+int popSuspendsUntilPush() {
+    typed::AsyncQueue<int> queue(DEFAULT_MAX_QUEUE_SIZE);
+    int received = 0;
+
+    consumeOne(queue, received);
+    assert(received == 0);
+
+    assert(queue.try_push(42));
+    assert(received == 42);
+    assert(queue.size() == 0);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that pop does not suspend when an element is already queued.
+ */
+int popReadyElement() {
+    typed::AsyncQueue<int> queue(DEFAULT_MAX_QUEUE_SIZE);
+    int received = 0;
+
+    assert(queue.try_push(7));
+    consumeOne(queue, received);
+    assert(received == 7);
+    assert(!queue.try_pop().has_value());
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that push suspends on a full queue and resumes, in order, as elements are popped.
+ */
+int pushSuspendsWhenFull() {
+    typed::AsyncQueue<int> queue(2);
+    int produced = 0;
+
+    produceAll(queue, 1, 5, produced);
+    assert(produced == 2);
+    assert(queue.size() == 2);
+    assert(!queue.try_push(99));
+
+    for (int i = 1; i <= 5; i++) {
+        assert(queue.try_pop() == i);
+    }
+    assert(produced == 5);
+    assert(queue.size() == 0);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that consumers suspended on the same queue are served first come, first served.
+ */
+int waitingConsumersServedInOrder() {
+    typed::AsyncQueue<int> queue(DEFAULT_MAX_QUEUE_SIZE);
+    int first = 0;
+    int second = 0;
+    int produced = 0;
+
+    consumeOne(queue, first);
+    consumeOne(queue, second);
+    produceAll(queue, 1, 2, produced);
+
+    assert(first == 1);
+    assert(second == 2);
+    assert(queue.size() == 0);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a move-only element type can pass through the queue.
+ */
+Detached consumeBox(typed::AsyncQueue<std::unique_ptr<int>>& queue, int& out) {
+    std::unique_ptr<int> box = co_await queue.pop();
+    out = *box;
+}
+
+int moveOnlyElements() {
+    typed::AsyncQueue<std::unique_ptr<int>> queue(1);
+    int received = 0;
+
+    consumeBox(queue, received);
+    assert(queue.try_push(std::make_unique<int>(5)));
+    assert(received == 5);
+
+    return TEST_SUCCESS;
+}
+
+Detached pooledConsumer(typed::ThreadPoolScheduler& pool, typed::AsyncQueue<int>& queue,
+        std::atomic<long>& sum, std::atomic<int>& done) {
+    co_await pool.yield();
+    int value = co_await queue.pop();
+    sum += value;
+    done++;
+}
+
+Detached pooledProducer(typed::ThreadPoolScheduler& pool, typed::AsyncQueue<int>& queue, int first, int last) {
+    co_await pool.yield();
+    for (int i = first; i <= last; i++) {
+        co_await queue.push(i);
+    }
+}
+
+/*
+ * Checks that thousands of consumer coroutines share a few threads through a scheduler.
+ */
+int manyConsumersOnFewThreads() {
+    typed::ThreadPoolScheduler pool(NUM_THREADS);
+    typed::AsyncQueue<int> queue(DEFAULT_MAX_QUEUE_SIZE, &pool);
+    std::atomic<long> sum(0);
+    std::atomic<int> done(0);
+
+    for (int i = 0; i < NUM_CONSUMERS; i++) {
+        pooledConsumer(pool, queue, sum, done);
+    }
+    pooledProducer(pool, queue, 1, NUM_CONSUMERS / 2);
+    pooledProducer(pool, queue, NUM_CONSUMERS / 2 + 1, NUM_CONSUMERS);
+
+    while (done.load() < NUM_CONSUMERS) {
+        std::this_thread::yield();
+    }
+    assert(sum.load() == (long) NUM_CONSUMERS * (NUM_CONSUMERS + 1) / 2);
+    assert(queue.size() == 0);
+
+    return TEST_SUCCESS;
+}
+
+
+/*
+ * Main function for the async queue tests which will run each user-defined test in turn.
+ */
+
+int main() {
+    runTest(popSuspendsUntilPush);
+    runTest(popReadyElement);
+    runTest(pushSuspendsWhenFull);
+    runTest(waitingConsumersServedInOrder);
+    runTest(moveOnlyElements);
+    runTest(manyConsumersOnFewThreads);
+
+    printf("\nAsyncQueue Tests complete: %d / %d tests successful.\n----------------\n", success_count, total_count);
+
+}
@@ -10,12 +10,20 @@
 #include <unistd.h>
 
 #include "BlockingQueue.h"
+#include "ReservedRing.h"
 #include "myassert.h"
 
 
 #define DEFAULT_MAX_QUEUE_SIZE 20
 #define NUM_THREADS 2
 
+/*
+ * Name printed in the summary, overridden when these tests are reused for another queue.
+ */
+#ifndef TEST_QUEUE_NAME
+#define TEST_QUEUE_NAME "BlockingQueue"
+#endif
+
 /*
  * The queue to use during tests
  */
@@ -422,6 +430,299 @@ int concurrentThreadMultipleDeq() {
     return TEST_SUCCESS;
 }
 
+/*
+ * Tests for BlockingQueue features beyond the basic interface, skipped when these tests
+ * are reused for a queue without them.
+ */
+#ifndef TEST_SKIP_EXTENSIONS
+
+/*
+ * Number of elements passed to countDrop.
+ */
+static int drop_count = 0;
+
+/*
+ * Drop callback for dropOldestEvictsHead. Counts evicted elements.
+ */
+void countDrop(void *element) {
+    (void) element;
+    drop_count++;
+}
+
+/*
+ * Checks that a full REJECT queue returns false without blocking and counts the rejection.
+ */
+int rejectWhenFull() {
+    BlockingQueue *rejecting = new_BlockingQueueWithPolicy(2, BLOCKING_QUEUE_REJECT, NULL);
+    assert(BlockingQueue_enq(rejecting, (void *) 1) == true);
+    assert(BlockingQueue_enq(rejecting, (void *) 2) == true);
+    assert(BlockingQueue_enq(rejecting, (void *) 3) == false);
+    assert(BlockingQueue_rejected(rejecting) == 1);
+    assert(BlockingQueue_dropped(rejecting) == 0);
+
+    assert(BlockingQueue_deq(rejecting) == (void *) 1);
+    assert(BlockingQueue_enq(rejecting, (void *) 4) == true);
+    assert(BlockingQueue_deq(rejecting) == (void *) 2);
+    assert(BlockingQueue_deq(rejecting) == (void *) 4);
+
+    BlockingQueue_destroy(rejecting);
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a full DROP_OLDEST queue evicts the head, hands it to the callback and keeps FIFO order.
+ */
+int dropOldestEvictsHead() {
+    drop_count = 0;
+    assert(new_BlockingQueueWithPolicy(0, BLOCKING_QUEUE_DROP_OLDEST, countDrop) == NULL);
+    BlockingQueue *dropping = new_BlockingQueueWithPolicy(3, BLOCKING_QUEUE_DROP_OLDEST, countDrop);
+    for (long i = 1; i <= 5; i++) {
+        assert(BlockingQueue_enq(dropping, (void *) i) == true);
+    }
+    assert(BlockingQueue_size(dropping) == 3);
+    assert(BlockingQueue_dropped(dropping) == 2);
+    assert(drop_count == 2);
+
+    assert(BlockingQueue_deq(dropping) == (void *) 3);
+    assert(BlockingQueue_deq(dropping) == (void *) 4);
+    assert(BlockingQueue_deq(dropping) == (void *) 5);
+
+    BlockingQueue_destroy(dropping);
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that an OVERWRITE queue behaves as a ring holding the newest elements.
+ */
+int overwriteRing() {
+    assert(new_BlockingQueueWithPolicy(0, BLOCKING_QUEUE_OVERWRITE, NULL) == NULL);
+    BlockingQueue *ring = new_BlockingQueueWithPolicy(4, BLOCKING_QUEUE_OVERWRITE, NULL);
+    for (long i = 1; i <= 10; i++) {
+        assert(BlockingQueue_enq(ring, (void *) i) == true);
+    }
+    assert(BlockingQueue_size(ring) == 4);
+    assert(BlockingQueue_dropped(ring) == 6);
+
+    for (long i = 7; i <= 10; i++) {
+        assert(BlockingQueue_deq(ring) == (void *) i);
+    }
+    assert(BlockingQueue_isEmpty(ring) == true);
+
+    BlockingQueue_destroy(ring);
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that elements can be enqueued after clearing a full queue.
+ */
+int enqAfterClear() {
+    for (long i = 1; i <= DEFAULT_MAX_QUEUE_SIZE; i++) {
+        assert(BlockingQueue_enq(queue, (void *) i) == true);
+    }
+    BlockingQueue_clear(queue);
+
+    for (long i = 1; i <= DEFAULT_MAX_QUEUE_SIZE; i++) {
+        assert(BlockingQueue_enq(queue, (void *) i) == true);
+    }
+    assert(BlockingQueue_deq(queue) == (void *) 1);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a reserved BlockingQueue behaves like a normal one and keeps little memory resident.
+ */
+int reservedQueueEnqDeq() {
+    BlockingQueue *reserved = new_BlockingQueueReserved(SEM_VALUE_MAX, BLOCKING_QUEUE_BLOCK, NULL);
+    assert(reserved != NULL);
+    assert(new_BlockingQueueReserved((size_t) SEM_VALUE_MAX + 1, BLOCKING_QUEUE_BLOCK, NULL) == NULL);
+
+    for (long i = 1; i <= 100000; i++) {
+        assert(BlockingQueue_enq(reserved, (void *) i) == true);
+    }
+    for (long i = 1; i <= 100000; i++) {
+        assert(BlockingQueue_deq(reserved) == (void *) i);
+    }
+    assert(BlockingQueue_isEmpty(reserved) == true);
+    assert(ReservedRing_residentBytes(reserved->array, reserved->maxSize) <= 2 * RESERVED_RING_BATCH_SLOTS * sizeof(void*));
+
+    BlockingQueue_destroy(reserved);
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that tryDeq returns NULL on an empty queue and dequeues in order otherwise.
+ */
+int tryDeqDoesNotBlock() {
+    assert(BlockingQueue_tryDeq(queue) == NULL);
+    BlockingQueue_enq(queue, (void *) 1);
+    BlockingQueue_enq(queue, (void *) 2);
+
+    assert(BlockingQueue_tryDeq(queue) == (void *) 1);
+    assert(BlockingQueue_tryDeq(queue) == (void *) 2);
+    assert(BlockingQueue_tryDeq(queue) == NULL);
+    assert(BlockingQueue_isEmpty(queue) == true);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that tryEnqBatch enqueues what fits in order and stops without blocking when full.
+ */
+int tryEnqBatchDoesNotBlock() {
+    void *elements[DEFAULT_MAX_QUEUE_SIZE + 2];
+    for (long i = 0; i < DEFAULT_MAX_QUEUE_SIZE + 2; i++) {
+        elements[i] = (void *) (i + 1);
+    }
+    elements[1] = NULL;
+
+    assert(BlockingQueue_tryEnqBatch(queue, elements, DEFAULT_MAX_QUEUE_SIZE + 2) == DEFAULT_MAX_QUEUE_SIZE + 1);
+    assert(BlockingQueue_size(queue) == DEFAULT_MAX_QUEUE_SIZE);
+    assert(BlockingQueue_tryEnqBatch(queue, elements + DEFAULT_MAX_QUEUE_SIZE + 1, 1) == 0);
+
+    assert(BlockingQueue_deq(queue) == (void *) 1);
+    for (long i = 3; i <= DEFAULT_MAX_QUEUE_SIZE + 1; i++) {
+        assert(BlockingQueue_deq(queue) == (void *) i);
+    }
+    assert(BlockingQueue_tryEnqBatch(queue, elements + DEFAULT_MAX_QUEUE_SIZE + 1, 1) == 1);
+    assert(BlockingQueue_deq(queue) == (void *) (DEFAULT_MAX_QUEUE_SIZE + 2));
+    assert(BlockingQueue_isEmpty(queue) == true);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that deqBatch takes what is available up to its limit, in order.
+ */
+int deqBatchTakesAvailable() {
+    for (long i = 1; i <= 5; i++) {
+        BlockingQueue_enq(queue, (void *) i);
+    }
+
+    void *elements[4];
+    assert(BlockingQueue_deqBatch(queue, elements, 0) == 0);
+    assert(BlockingQueue_deqBatch(queue, elements, 4) == 4);
+    for (long i = 1; i <= 4; i++) {
+        assert(elements[i - 1] == (void *) i);
+    }
+    assert(BlockingQueue_deqBatch(queue, elements, 4) == 1);
+    assert(elements[0] == (void *) 5);
+    assert(BlockingQueue_isEmpty(queue) == true);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Waits until a thread is parked on the given waiter list of a handoff queue.
+ */
+void waitParked(BlockingQueue *handoff, BlockingQueueWaiter **list) {
+    for (;;) {
+        pthread_mutex_lock(&(handoff->mutex));
+        bool parked = *list != NULL;
+        pthread_mutex_unlock(&(handoff->mutex));
+        if (parked) {
+            return;
+        }
+        usleep(100);
+    }
+}
+
+/*
+ * Helper thread for the handoff tests: dequeues one element and returns it.
+ */
+void *deqOne(void *arg) {
+    return BlockingQueue_deq((BlockingQueue *) arg);
+}
+
+/*
+ * Helper thread for the handoff tests: enqueues element 3 and returns once it is accepted.
+ */
+void *enqThree(void *arg) {
+    BlockingQueue_enq((BlockingQueue *) arg, (void *) 3);
+    return (void *) TEST_SUCCESS;
+}
+
+/*
+ * Checks that enq hands elements straight to parked consumers, first parked first served.
+ */
+int handoffToParkedConsumers() {
+    BlockingQueue *handoff = new_BlockingQueueHandoff(4);
+    pthread_t first, second;
+    pthread_create(&first, NULL, deqOne, handoff);
+    waitParked(handoff, &(handoff->consumers));
+    pthread_create(&second, NULL, deqOne, handoff);
+    waitParked(handoff, &(handoff->consumers->next));
+
+    assert(BlockingQueue_enq(handoff, (void *) 1) == true);
+    assert(BlockingQueue_enq(handoff, (void *) 2) == true);
+    void *result;
+    pthread_join(first, &result);
+    assert(result == (void *) 1);
+    pthread_join(second, &result);
+    assert(result == (void *) 2);
+    assert(BlockingQueue_isEmpty(handoff) == true);
+
+    BlockingQueue_destroy(handoff);
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a full handoff queue refills from parked producers in order, on deq and on clear.
+ */
+int handoffRefillsFromParkedProducer() {
+    BlockingQueue *handoff = new_BlockingQueueHandoff(2);
+    pthread_t producer;
+    BlockingQueue_enq(handoff, (void *) 1);
+    BlockingQueue_enq(handoff, (void *) 2);
+    pthread_create(&producer, NULL, enqThree, handoff);
+    waitParked(handoff, &(handoff->producers));
+
+    assert(BlockingQueue_deq(handoff) == (void *) 1);
+    pthread_join(producer, NULL);
+    assert(BlockingQueue_size(handoff) == 2);
+
+    pthread_create(&producer, NULL, enqThree, handoff);
+    waitParked(handoff, &(handoff->producers));
+    BlockingQueue_clear(handoff);
+    pthread_join(producer, NULL);
+    assert(BlockingQueue_size(handoff) == 1);
+    assert(BlockingQueue_tryDeq(handoff) == (void *) 3);
+    assert(BlockingQueue_tryDeq(handoff) == NULL);
+
+    BlockingQueue_destroy(handoff);
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a synchronous queue holds nothing and every enq waits for a deq.
+ */
+int synchronousQueueRendezvous() {
+    BlockingQueue *sync = new_BlockingQueueSynchronous();
+    assert(sync != NULL);
+    assert(BlockingQueue_tryDeq(sync) == NULL);
+
+    pthread_t producer;
+    pthread_create(&producer, NULL, enqThree, sync);
+    waitParked(sync, &(sync->producers));
+    assert(BlockingQueue_size(sync) == 0);
+    assert(BlockingQueue_tryDeq(sync) == (void *) 3);
+    pthread_join(producer, NULL);
+
+    pthread_t consumer;
+    void *result;
+    pthread_create(&consumer, NULL, deqOne, sync);
+    waitParked(sync, &(sync->consumers));
+    assert(BlockingQueue_enq(sync, (void *) 4) == true);
+    pthread_join(consumer, &result);
+    assert(result == (void *) 4);
+    assert(BlockingQueue_isEmpty(sync) == true);
+
+    BlockingQueue_destroy(sync);
+    return TEST_SUCCESS;
+}
+
+#endif /* TEST_SKIP_EXTENSIONS */
+
 /*
  * Write more of your own test functions below (such as enqOneElement, enqAndDeqOneElement, ...)
  * to help you verify correctness of your BlockingQueue.
@@ -447,6 +748,19 @@ int main() {
     runTest(queueClearEmpty);
     runTest(concurrentThreadMultipleEnq);
     runTest(concurrentThreadMultipleDeq);
+#ifndef TEST_SKIP_EXTENSIONS
+    runTest(rejectWhenFull);
+    runTest(dropOldestEvictsHead);
+    runTest(overwriteRing);
+    runTest(enqAfterClear);
+    runTest(reservedQueueEnqDeq);
+    runTest(tryDeqDoesNotBlock);
+    runTest(tryEnqBatchDoesNotBlock);
+    runTest(deqBatchTakesAvailable);
+    runTest(handoffToParkedConsumers);
+    runTest(handoffRefillsFromParkedProducer);
+    runTest(synchronousQueueRendezvous);
+#endif
     /*
      * you will have to call runTest on all your test functions above, such as
      *
@@ -455,6 +769,6 @@ int main() {
      *
      */
 
-    printf("\nBlockingQueue Tests complete: %d / %d tests successful.\n----------------\n", success_count, total_count);
+    printf("\n%s Tests complete: %d / %d tests successful.\n----------------\n", TEST_QUEUE_NAME, success_count, total_count);
 
 }
@@ -0,0 +1,272 @@
+/*
+ * TestBlockingQueueProducer.c
+ *
+ * Very simple unit test file for BlockingQueueProducer functionality.
+ *
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "BlockingQueue.h"
+#include "BlockingQueueProducer.h"
+#include "myassert.h"
+
+
+#define DEFAULT_MAX_QUEUE_SIZE 20
+#define DEFAULT_BATCH_SIZE 4
+#define NUM_PRODUCERS 4
+#define ELEMENTS_PER_PRODUCER 5000
+
+/*
+ * The queue to use during tests
+ */
+static BlockingQueue *queue;
+
+/*
+ * The number of tests that succeeded
+ */
+static int success_count = 0;
+
+/*
+ * The total number of tests run
+ */
+static int total_count = 0;
+
+
+/*
+ * Setup function to run prior to each test
+ */
+void setup(){
+    queue = new_BlockingQueue(DEFAULT_MAX_QUEUE_SIZE);
+    total_count++;
+}
+
+/*
+ * Teardown function to run after each test
+ */
+void teardown(){
+    BlockingQueue_destroy(queue);
+}
+
+/*
+ * This function is called multiple times from main for each user-defined test function
+ */
+void runTest(int (*testFunction)()) {
+    setup();
+
+    if (testFunction()) success_count++;
+
+    teardown();
+}
+
+
+/*
+ * Checks that the constructor returns a non-NULL handle and rejects bad arguments.
+ */
+int newProducerIsNotNull() {
+    BlockingQueueProducer *producer = new_BlockingQueueProducer(queue, DEFAULT_BATCH_SIZE, 0);
+    assert(producer != NULL);
+    assert(BlockingQueueProducer_pending(producer) == 0);
+    assert(new_BlockingQueueProducer(queue, 0, 0) == NULL);
+    assert(new_BlockingQueueProducer(NULL, DEFAULT_BATCH_SIZE, 0) == NULL);
+
+    BlockingQueueProducer_destroy(producer);
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that staging a NULL element returns false.
+ */
+int enqNullElement() {
+    BlockingQueueProducer *producer = new_BlockingQueueProducer(queue, DEFAULT_BATCH_SIZE, 0);
+    assert(BlockingQueueProducer_enq(producer, NULL) == false);
+    assert(BlockingQueueProducer_pending(producer) == 0);
+
+    BlockingQueueProducer_destroy(producer);
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that elements stay staged until the batch is full and are then published in order.
+ */
+int publishWhenFull() {
+    BlockingQueueProducer *producer = new_BlockingQueueProducer(queue, DEFAULT_BATCH_SIZE, 0);
+    for (long i = 1; i < DEFAULT_BATCH_SIZE; i++) {
+        assert(BlockingQueueProducer_enq(producer, (void *) i) == true);
+    }
+    assert(BlockingQueue_size(queue) == 0);
+    assert(BlockingQueueProducer_pending(producer) == DEFAULT_BATCH_SIZE - 1);
+
+    assert(BlockingQueueProducer_enq(producer, (void *) DEFAULT_BATCH_SIZE) == true);
+    assert(BlockingQueue_size(queue) == DEFAULT_BATCH_SIZE);
+    assert(BlockingQueueProducer_pending(producer) == 0);
+    for (long i = 1; i <= DEFAULT_BATCH_SIZE; i++) {
+        assert(BlockingQueue_deq(queue) == (void *) i);
+    }
+
+    BlockingQueueProducer_destroy(producer);
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that an explicit flush and destroying the handle publish staged elements.
+ */
+int publishOnFlushAndDestroy() {
+    BlockingQueueProducer *producer = new_BlockingQueueProducer(queue, DEFAULT_BATCH_SIZE, 0);
+    BlockingQueueProducer_enq(producer, (void *) 1);
+    BlockingQueueProducer_flush(producer);
+    assert(BlockingQueue_size(queue) == 1);
+
+    BlockingQueueProducer_enq(producer, (void *) 2);
+    BlockingQueueProducer_destroy(producer);
+    assert(BlockingQueue_size(queue) == 2);
+    assert(BlockingQueue_deq(queue) == (void *) 1);
+    assert(BlockingQueue_deq(queue) == (void *) 2);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that an idle producer's staged elements are published after the maximum delay.
+ */
+int publishAfterMaxDelay() {
+    BlockingQueueProducer *producer = new_BlockingQueueProducer(queue, DEFAULT_BATCH_SIZE, 2000);
+    BlockingQueueProducer_enq(producer, (void *) 1);
+    assert(BlockingQueue_size(queue) == 0);
+
+    /* deq blocks until the flusher thread publishes the element. */
+    assert(BlockingQueue_deq(queue) == (void *) 1);
+    assert(BlockingQueueProducer_pending(producer) == 0);
+
+    BlockingQueueProducer_destroy(producer);
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a handle whose queue stays full neither blocks new handles nor delays the
+ * timed flush of handles on other queues, and is published once its queue has room.
+ */
+int fullQueueDoesNotStallFlusher() {
+    BlockingQueue *full = new_BlockingQueue(1);
+    BlockingQueue_enq(full, (void *) 1);
+    BlockingQueueProducer *stuck = new_BlockingQueueProducer(full, DEFAULT_BATCH_SIZE, 1000);
+    BlockingQueueProducer_enq(stuck, (void *) 2);
+    BlockingQueueProducer_enq(stuck, (void *) 3);
+    usleep(5000);
+
+    BlockingQueueProducer *producer = new_BlockingQueueProducer(queue, DEFAULT_BATCH_SIZE, 1000);
+    assert(producer != NULL);
+    BlockingQueueProducer_enq(producer, (void *) 4);
+    assert(BlockingQueue_deq(queue) == (void *) 4);
+    assert(BlockingQueueProducer_pending(stuck) == 2);
+
+    assert(BlockingQueue_deq(full) == (void *) 1);
+    assert(BlockingQueue_deq(full) == (void *) 2);
+    assert(BlockingQueue_deq(full) == (void *) 3);
+    assert(BlockingQueueProducer_pending(stuck) == 0);
+
+    BlockingQueueProducer_destroy(producer);
+    BlockingQueueProducer_destroy(stuck);
+    BlockingQueue_destroy(full);
+    return TEST_SUCCESS;
+}
+
+/*
+ * Helper function for batchLargerThanQueue. Dequeues the batch, checking it skips the NULL element.
+ */
+void *deqBatch(void *arg) {
+    (void) arg;
+    for (long i = 1; i <= 2 * DEFAULT_MAX_QUEUE_SIZE; i++) {
+        if (i == 4) {
+            continue;
+        }
+        if (BlockingQueue_deq(queue) != (void *) i) {
+            return (void *) ASSERTION_FAILURE;
+        }
+    }
+    return (void *) TEST_SUCCESS;
+}
+
+/*
+ * Checks that a batch larger than the queue is enqueued in order without deadlocking.
+ */
+int batchLargerThanQueue() {
+    void *elements[2 * DEFAULT_MAX_QUEUE_SIZE];
+    for (long i = 0; i < 2 * DEFAULT_MAX_QUEUE_SIZE; i++) {
+        elements[i] = (void *) (i + 1);
+    }
+    elements[3] = NULL;
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, deqBatch, NULL);
+    assert(BlockingQueue_enqBatch(queue, elements, 2 * DEFAULT_MAX_QUEUE_SIZE) == 2 * DEFAULT_MAX_QUEUE_SIZE - 1);
+
+    void *result;
+    pthread_join(thread, &result);
+    assert(result == (void *) TEST_SUCCESS);
+    assert(BlockingQueue_isEmpty(queue) == true);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Helper function for concurrentProducersKeepOrder. Stages ELEMENTS_PER_PRODUCER
+ * increasing values tagged with the producer number.
+ */
+void *produceTagged(void *arg) {
+    long tag = (long) arg;
+    BlockingQueueProducer *producer = new_BlockingQueueProducer(queue, DEFAULT_BATCH_SIZE, 1000);
+    for (long i = 1; i <= ELEMENTS_PER_PRODUCER; i++) {
+        BlockingQueueProducer_enq(producer, (void *) (tag * 1000000 + i));
+    }
+    BlockingQueueProducer_destroy(producer);
+    return NULL;
+}
+
+/*
+ * Checks that each producer's elements arrive in FIFO order when several producers share a queue.
+ */
+int concurrentProducersKeepOrder() {
+    pthread_t threads[NUM_PRODUCERS];
+    for (long i = 0; i < NUM_PRODUCERS; i++) {
+        pthread_create(&threads[i], NULL, produceTagged, (void *) (i + 1));
+    }
+
+    long last[NUM_PRODUCERS + 1] = { 0 };
+    for (long i = 0; i < NUM_PRODUCERS * ELEMENTS_PER_PRODUCER; i++) {
+        long value = (long) BlockingQueue_deq(queue);
+        long tag = value / 1000000;
+        assert(tag >= 1 && tag <= NUM_PRODUCERS);
+        assert(value % 1000000 == last[tag] + 1);
+        last[tag] = value % 1000000;
+    }
+
+    for (int i = 0; i < NUM_PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    assert(BlockingQueue_isEmpty(queue) == true);
+
+    return TEST_SUCCESS;
+}
+
+
+/*
+ * Main function for the BlockingQueueProducer tests which will run each user-defined test in turn.
+ */
+
+int main() {
+    runTest(newProducerIsNotNull);
+    runTest(enqNullElement);
+    runTest(publishWhenFull);
+    runTest(publishOnFlushAndDestroy);
+    runTest(publishAfterMaxDelay);
+    runTest(fullQueueDoesNotStallFlusher);
+    runTest(batchLargerThanQueue);
+    runTest(concurrentProducersKeepOrder);
+
+    printf("\nBlockingQueueProducer Tests complete: %d / %d tests successful.\n----------------\n", success_count, total_count);
+
+}
@@ -0,0 +1,244 @@
+/*
+ * TestBroadcastRing.c
+ *
+ * Very simple unit test file for BroadcastRing functionality.
+ *
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "BroadcastRing.h"
+#include "myassert.h"
+
+
+#define DEFAULT_RING_SIZE 8
+#define NUM_EVENTS 20000
+#define NUM_CONSUMERS 3
+
+/*
+ * The ring to use during tests
+ */
+static BroadcastRing *ring;
+
+/*
+ * The number of tests that succeeded
+ */
+static int success_count = 0;
+
+/*
+ * The total number of tests run
+ */
+static int total_count = 0;
+
+/*
+ * Per-event stage markers written by the first stage and checked by the second in stagesRespectDependencies.
+ */
+static _Atomic int stage[NUM_EVENTS + 1];
+
+
+/*
+ * Setup function to run prior to each test
+ */
+void setup(){
+    ring = new_BroadcastRing(DEFAULT_RING_SIZE);
+    total_count++;
+}
+
+/*
+ * Teardown function to run after each test
+ */
+void teardown(){
+    BroadcastRing_destroy(ring);
+}
+
+/*
+ * This function is called multiple times from main for each user-defined test function
+ */
+void runTest(int (*testFunction)()) {
+    setup();
+
+    if (testFunction()) success_count++;
+
+    teardown();
+}
+
+
+/*
+ * Checks that the BroadcastRing constructor returns a non-NULL pointer and rejects bad sizes.
+ */
+int newRingIsNotNull() {
+    assert(ring != NULL);
+    assert(ring->mask + 1 == DEFAULT_RING_SIZE);
+    assert(new_BroadcastRing(0) == NULL);
+
+    BroadcastRing *rounded = new_BroadcastRing(5);
+    assert(rounded->mask + 1 == 8);
+    BroadcastRing_destroy(rounded);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that publishing a NULL element returns false.
+ */
+int publishNullElement() {
+    BroadcastConsumer *consumer = BroadcastRing_addConsumer(ring, NULL, 0);
+    assert(BroadcastRing_publish(ring, NULL) == false);
+    assert(BroadcastConsumer_backlog(consumer) == 0);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that every consumer sees every element in order.
+ */
+int everyConsumerSeesEveryElement() {
+    BroadcastConsumer *first = BroadcastRing_addConsumer(ring, NULL, 0);
+    BroadcastConsumer *second = BroadcastRing_addConsumer(ring, NULL, 0);
+
+    for (long i = 1; i <= DEFAULT_RING_SIZE; i++) {
+        assert(BroadcastRing_publish(ring, (void *) i) == true);
+    }
+    assert(BroadcastConsumer_backlog(first) == DEFAULT_RING_SIZE);
+
+    for (long i = 1; i <= DEFAULT_RING_SIZE; i++) {
+        assert(BroadcastConsumer_wait(first) == (void *) i);
+        BroadcastConsumer_commit(first);
+    }
+    for (long i = 1; i <= DEFAULT_RING_SIZE; i++) {
+        assert(BroadcastConsumer_wait(second) == (void *) i);
+        BroadcastConsumer_commit(second);
+    }
+    assert(BroadcastConsumer_backlog(first) == 0);
+    assert(BroadcastConsumer_backlog(second) == 0);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Helper function for publisherGatedBySlowestConsumer. Publishes one more element than fits.
+ */
+void *publishOverflow(void *arg) {
+    BroadcastRing *target = (BroadcastRing *) arg;
+    for (long i = 1; i <= DEFAULT_RING_SIZE + 1; i++) {
+        BroadcastRing_publish(target, (void *) i);
+    }
+    return NULL;
+}
+
+/*
+ * Checks that the publisher blocks until the slowest consumer frees a slot.
+ */
+int publisherGatedBySlowestConsumer() {
+    BroadcastConsumer *fast = BroadcastRing_addConsumer(ring, NULL, 0);
+    BroadcastConsumer *slow = BroadcastRing_addConsumer(ring, NULL, 0);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, publishOverflow, (void *) ring);
+
+    for (long i = 1; i <= DEFAULT_RING_SIZE; i++) {
+        assert(BroadcastConsumer_wait(fast) == (void *) i);
+        BroadcastConsumer_commit(fast);
+    }
+    assert(BroadcastConsumer_backlog(slow) == DEFAULT_RING_SIZE);
+    assert(BroadcastConsumer_backlog(fast) == 0);
+
+    assert(BroadcastConsumer_wait(slow) == (void *) 1);
+    BroadcastConsumer_commit(slow);
+    pthread_join(thread, NULL);
+    assert(BroadcastConsumer_backlog(slow) == DEFAULT_RING_SIZE);
+    assert(BroadcastConsumer_wait(fast) == (void *) (DEFAULT_RING_SIZE + 1));
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Helper function for concurrent tests. Consumes NUM_EVENTS elements, checking order and,
+ * for dependent consumers, that the first stage has already marked each element.
+ */
+void *consumeEvents(void *arg) {
+    BroadcastConsumer *consumer = (BroadcastConsumer *) arg;
+    for (long i = 1; i <= NUM_EVENTS; i++) {
+        long event = (long) BroadcastConsumer_wait(consumer);
+        if (event != i) {
+            return (void *) ASSERTION_FAILURE;
+        }
+        if (consumer->numDependencies == 0) {
+            stage[event] = 1;
+        } else if (stage[event] != 1) {
+            return (void *) ASSERTION_FAILURE;
+        }
+        BroadcastConsumer_commit(consumer);
+    }
+    return (void *) TEST_SUCCESS;
+}
+
+/*
+ * Checks that several concurrent consumers each receive the full stream from one publisher.
+ */
+int concurrentMulticast() {
+    BroadcastConsumer *consumers[NUM_CONSUMERS];
+    pthread_t threads[NUM_CONSUMERS];
+    for (int i = 0; i < NUM_CONSUMERS; i++) {
+        consumers[i] = BroadcastRing_addConsumer(ring, NULL, 0);
+        pthread_create(&threads[i], NULL, consumeEvents, (void *) consumers[i]);
+    }
+
+    for (long i = 1; i <= NUM_EVENTS; i++) {
+        BroadcastRing_publish(ring, (void *) i);
+    }
+
+    for (int i = 0; i < NUM_CONSUMERS; i++) {
+        void *result;
+        pthread_join(threads[i], &result);
+        assert(result == (void *) TEST_SUCCESS);
+    }
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a dependent consumer only sees elements after its dependency committed them.
+ */
+int stagesRespectDependencies() {
+    for (int i = 0; i <= NUM_EVENTS; i++) {
+        stage[i] = 0;
+    }
+    BroadcastConsumer *first = BroadcastRing_addConsumer(ring, NULL, 0);
+    BroadcastConsumer *second = BroadcastRing_addConsumer(ring, &first, 1);
+
+    pthread_t threads[2];
+    pthread_create(&threads[0], NULL, consumeEvents, (void *) second);
+    pthread_create(&threads[1], NULL, consumeEvents, (void *) first);
+
+    for (long i = 1; i <= NUM_EVENTS; i++) {
+        BroadcastRing_publish(ring, (void *) i);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        void *result;
+        pthread_join(threads[i], &result);
+        assert(result == (void *) TEST_SUCCESS);
+    }
+
+    return TEST_SUCCESS;
+}
+
+
+/*
+ * Main function for the BroadcastRing tests which will run each user-defined test in turn.
+ */
+
+int main() {
+    runTest(newRingIsNotNull);
+    runTest(publishNullElement);
+    runTest(everyConsumerSeesEveryElement);
+    runTest(publisherGatedBySlowestConsumer);
+    runTest(concurrentMulticast);
+    runTest(stagesRespectDependencies);
+
+    printf("\nBroadcastRing Tests complete: %d / %d tests successful.\n----------------\n", success_count, total_count);
+
+}
@@ -0,0 +1,331 @@
+/*
+ * TestByteRing.c
+ *
+ * Very simple unit test file for ByteRing functionality.
+ *
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "ByteRing.h"
+#include "myassert.h"
+
+
+#define DEFAULT_RING_SIZE 256
+#define NUM_MESSAGES 20000
+#define NUM_PRODUCERS 2
+
+/*
+ * The ring to use during tests
+ */
+static ByteRing *ring;
+
+/*
+ * The number of tests that succeeded
+ */
+static int success_count = 0;
+
+/*
+ * The total number of tests run
+ */
+static int total_count = 0;
+
+
+/*
+ * Setup function to run prior to each test
+ */
+void setup(){
+    ring = new_ByteRing(DEFAULT_RING_SIZE);
+    total_count++;
+}
+
+/*
+ * Teardown function to run after each test
+ */
+void teardown(){
+    ByteRing_destroy(ring);
+}
+
+/*
+ * This function is called multiple times from main for each user-defined test function
+ */
+void runTest(int (*testFunction)()) {
+    setup();
+
+    if (testFunction()) success_count++;
+
+    teardown();
+}
+
+/*
+ * Reserves, fills with the given byte and commits a record of the given length.
+ * Returns the reserved pointer.
+ */
+static void *writeRecord(size_t length, unsigned char fill) {
+    void *data = ByteRing_reserve(ring, length);
+    memset(data, fill, length);
+    ByteRing_commit(ring, data, length);
+    return data;
+}
+
+/*
+ * Returns true if the length bytes at data all equal fill.
+ */
+static bool filledWith(const void *data, size_t length, unsigned char fill) {
+    for (size_t i = 0; i < length; i++) {
+        if (((const unsigned char *) data)[i] != fill) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/*
+ * Checks that the ByteRing constructor returns a non-NULL pointer and rounds capacity up.
+ */
+int newRingIsNotNull() {
+    assert(ring != NULL);
+    assert(ByteRing_capacity(ring) == DEFAULT_RING_SIZE);
+    assert(ByteRing_usedBytes(ring) == 0);
+    assert(new_ByteRing(0) == NULL);
+
+    ByteRing *rounded = new_ByteRing(100);
+    assert(ByteRing_capacity(rounded) == 112);
+    ByteRing_destroy(rounded);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a consumer reads the committed bytes in place, at the address the producer wrote.
+ */
+int reserveCommitRead() {
+    char *data = ByteRing_reserve(ring, 5);
+    assert(data != NULL);
+    assert((uintptr_t) data % BYTE_RING_ALIGN == 0);
+    memcpy(data, "hello", 5);
+    ByteRing_commit(ring, data, 5);
+    assert(ByteRing_usedBytes(ring) == sizeof(ByteRingRecord) + BYTE_RING_ALIGN);
+
+    size_t length = 0;
+    const char *read = ByteRing_read(ring, &length);
+    assert(read == data);
+    assert(length == 5);
+    assert(memcmp(read, "hello", 5) == 0);
+
+    ByteRing_release(ring, read);
+    assert(ByteRing_usedBytes(ring) == 0);
+    assert(ByteRing_tryRead(ring, &length) == NULL);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a record may be committed shorter than it was reserved.
+ */
+int commitShorterThanReserved() {
+    void *data = ByteRing_reserve(ring, 64);
+    memset(data, 7, 10);
+    ByteRing_commit(ring, data, 10);
+
+    size_t length = 0;
+    const void *read = ByteRing_read(ring, &length);
+    assert(length == 10);
+    assert(filledWith(read, 10, 7));
+    ByteRing_release(ring, read);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a record that can never fit is refused instead of blocking.
+ */
+int oversizedReserveFails() {
+    assert(ByteRing_reserve(ring, DEFAULT_RING_SIZE) == NULL);
+    assert(ByteRing_reserve(ring, SIZE_MAX) == NULL);
+
+    void *largest = ByteRing_reserve(ring, DEFAULT_RING_SIZE - sizeof(ByteRingRecord));
+    assert(largest != NULL);
+    assert(ByteRing_usedBytes(ring) == DEFAULT_RING_SIZE);
+    ByteRing_commit(ring, largest, 0);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that records are delivered in reservation order, even if committed out of order.
+ */
+int uncommittedRecordHoldsBackLaterOnes() {
+    void *first = ByteRing_reserve(ring, 8);
+    void *second = ByteRing_reserve(ring, 8);
+    memset(second, 2, 8);
+    ByteRing_commit(ring, second, 8);
+
+    size_t length;
+    assert(ByteRing_tryRead(ring, &length) == NULL);
+
+    memset(first, 1, 8);
+    ByteRing_commit(ring, first, 8);
+    const void *read = ByteRing_tryRead(ring, &length);
+    assert(read == first && filledWith(read, length, 1));
+    const void *next = ByteRing_tryRead(ring, &length);
+    assert(next == second && filledWith(next, length, 2));
+
+    ByteRing_release(ring, next);
+    assert(ByteRing_usedBytes(ring) == 2 * (sizeof(ByteRingRecord) + 16));
+    ByteRing_release(ring, read);
+    assert(ByteRing_usedBytes(ring) == 0);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a record which would straddle the end of the buffer is placed at its start
+ * behind a padding record, and that consumers skip the padding.
+ */
+int wrapAroundPadding() {
+    size_t length;
+    for (int i = 0; i < 3; i++) {
+        writeRecord(48, (unsigned char) i);
+    }
+    for (int i = 0; i < 2; i++) {
+        ByteRing_release(ring, ByteRing_read(ring, &length));
+    }
+
+    void *wrapped = writeRecord(80, 9);
+    assert((unsigned char *) wrapped == ring->buffer + sizeof(ByteRingRecord));
+    assert(ByteRing_usedBytes(ring) == 64 + 64 + 96);
+
+    const void *third = ByteRing_read(ring, &length);
+    assert(length == 48 && filledWith(third, length, 2));
+    const void *read = ByteRing_read(ring, &length);
+    assert(read == wrapped);
+    assert(length == 80 && filledWith(read, length, 9));
+
+    ByteRing_release(ring, third);
+    ByteRing_release(ring, read);
+    assert(ByteRing_usedBytes(ring) == 0);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Helper function for testReserveBlocking. Reserves and commits one record.
+ */
+void *reserveBlocking(void *arg) {
+    ByteRing *target = (ByteRing *) arg;
+    void *data = ByteRing_reserve(target, 64);
+    memset(data, 5, 64);
+    ByteRing_commit(target, data, 64);
+    return NULL;
+}
+
+/*
+ * Checks that reserve blocks while the ring is full and proceeds once a record is released.
+ */
+int testReserveBlocking() {
+    for (int i = 0; i < 4; i++) {
+        writeRecord(48, (unsigned char) i);
+    }
+    assert(ByteRing_usedBytes(ring) == DEFAULT_RING_SIZE);
+
+    pthread_t thread;
+    int result = pthread_create(&thread, NULL, reserveBlocking, (void *) ring);
+    assert(result == 0);
+    usleep(100);
+    assert(ByteRing_usedBytes(ring) == DEFAULT_RING_SIZE);
+
+    size_t length;
+    const void *first = ByteRing_read(ring, &length);
+    const void *second = ByteRing_read(ring, &length);
+    ByteRing_release(ring, first);
+    ByteRing_release(ring, second);
+
+    result = pthread_join(thread, NULL);
+    assert(result == 0);
+    for (int i = 2; i < 4; i++) {
+        const void *read = ByteRing_read(ring, &length);
+        assert(filledWith(read, length, (unsigned char) i));
+        ByteRing_release(ring, read);
+    }
+    const void *last = ByteRing_read(ring, &length);
+    assert(length == 64 && filledWith(last, length, 5));
+    ByteRing_release(ring, last);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Helper function for concurrentFramedMessages. Writes NUM_MESSAGES records of varying
+ * length, each starting with the producer id and sequence number followed by filler bytes.
+ */
+void *produceMessages(void *arg) {
+    long producer = (long) arg;
+    for (long i = 0; i < NUM_MESSAGES; i++) {
+        size_t length = 2 * sizeof(long) + (size_t) (i * 7 % 150);
+        unsigned char *data = ByteRing_reserve(ring, length);
+        memcpy(data, &producer, sizeof(long));
+        memcpy(data + sizeof(long), &i, sizeof(long));
+        memset(data + 2 * sizeof(long), (unsigned char) i, length - 2 * sizeof(long));
+        ByteRing_commit(ring, data, length);
+    }
+    return NULL;
+}
+
+/*
+ * Checks that concurrent producers' messages arrive intact and in per-producer order.
+ */
+int concurrentFramedMessages() {
+    pthread_t threads[NUM_PRODUCERS];
+    for (long i = 0; i < NUM_PRODUCERS; i++) {
+        pthread_create(&threads[i], NULL, produceMessages, (void *) i);
+    }
+
+    long next[NUM_PRODUCERS] = {0};
+    for (long n = 0; n < NUM_PRODUCERS * NUM_MESSAGES; n++) {
+        size_t length;
+        const unsigned char *data = ByteRing_read(ring, &length);
+        long producer;
+        long sequence;
+        memcpy(&producer, data, sizeof(long));
+        memcpy(&sequence, data + sizeof(long), sizeof(long));
+        assert(producer >= 0 && producer < NUM_PRODUCERS);
+        assert(sequence == next[producer]);
+        assert(length == 2 * sizeof(long) + (size_t) (sequence * 7 % 150));
+        assert(filledWith(data + 2 * sizeof(long), length - 2 * sizeof(long), (unsigned char) sequence));
+        next[producer]++;
+        ByteRing_release(ring, data);
+    }
+
+    for (int i = 0; i < NUM_PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    assert(ByteRing_usedBytes(ring) == 0);
+
+    return TEST_SUCCESS;
+}
+
+
+/*
+ * Main function for the ByteRing tests which will run each user-defined test in turn.
+ */
+
+int main() {
+    runTest(newRingIsNotNull);
+    runTest(reserveCommitRead);
+    runTest(commitShorterThanReserved);
+    runTest(oversizedReserveFails);
+    runTest(uncommittedRecordHoldsBackLaterOnes);
+    runTest(wrapAroundPadding);
+    runTest(testReserveBlocking);
+    runTest(concurrentFramedMessages);
+
+    printf("\nByteRing Tests complete: %d / %d tests successful.\n----------------\n", success_count, total_count);
+
+}
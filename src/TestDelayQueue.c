@@ -0,0 +1,249 @@
+/*
+ * TestDelayQueue.c
+ *
+ * Very simple unit test file for DelayQueue functionality.
+ *
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "DelayQueue.h"
+#include "myassert.h"
+
+
+#define DEFAULT_TICK_MS 1
+#define MANY_TIMERS 200000
+
+/*
+ * The queue to use during tests
+ */
+static DelayQueue *queue;
+
+/*
+ * The number of tests that succeeded
+ */
+static int success_count = 0;
+
+/*
+ * The total number of tests run
+ */
+static int total_count = 0;
+
+
+/*
+ * Setup function to run prior to each test
+ */
+void setup(){
+    queue = new_DelayQueue(DEFAULT_TICK_MS);
+    total_count++;
+}
+
+/*
+ * Teardown function to run after each test
+ */
+void teardown(){
+    DelayQueue_destroy(queue);
+}
+
+/*
+ * This function is called multiple times from main for each user-defined test function
+ */
+void runTest(int (*testFunction)()) {
+    setup();
+
+    if (testFunction()) success_count++;
+
+    teardown();
+}
+
+
+/*
+ * Checks that the DelayQueue constructor returns a non-NULL, empty queue.
+ */
+int newQueueIsNotNull() {
+    assert(queue != NULL);
+    assert(DelayQueue_size(queue) == 0);
+    assert(DelayQueue_isEmpty(queue) == true);
+    assert(new_DelayQueue(0) == NULL);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that enqueueing a NULL element returns an invalid id.
+ */
+int enqNullElement() {
+    assert(DelayQueue_enq(queue, NULL, 0) == 0);
+    assert(DelayQueue_size(queue) == 0);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that an element is not available before its due time and is available after.
+ */
+int elementNotDueEarly() {
+    assert(DelayQueue_enq(queue, (void *) 1, 50) != 0);
+    assert(DelayQueue_tryDeq(queue) == NULL);
+    assert(DelayQueue_size(queue) == 1);
+
+    uint64_t start = DelayQueue_nowMs();
+    assert(DelayQueue_deq(queue) == (void *) 1);
+    assert(DelayQueue_nowMs() - start >= 45);
+    assert(DelayQueue_isEmpty(queue) == true);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that elements come out in due order regardless of enqueue order.
+ */
+int deqInDueOrder() {
+    DelayQueue_enq(queue, (void *) 3, 30);
+    DelayQueue_enq(queue, (void *) 1, 0);
+    DelayQueue_enq(queue, (void *) 2, 10);
+
+    assert(DelayQueue_deq(queue) == (void *) 1);
+    assert(DelayQueue_deq(queue) == (void *) 2);
+    assert(DelayQueue_deq(queue) == (void *) 3);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that elements with the same due time come out in the order they were enqueued,
+ * whether they are due at once or wait in, and cascade between, wheel slots.
+ */
+int sameDueTimeIsFifo() {
+    /* Left idle, the wheel lags the clock, so even elements due now wait in a wheel slot. */
+    usleep(20000);
+    DelayQueue_enq(queue, (void *) 1, 0);
+    DelayQueue_enq(queue, (void *) 2, 0);
+    uint64_t soon = DelayQueue_nowMs() + 10;
+    uint64_t later = DelayQueue_nowMs() + 300;
+    for (long i = 3; i <= 5; i++) {
+        DelayQueue_enqAt(queue, (void *) i, soon);
+    }
+    for (long i = 6; i <= 8; i++) {
+        DelayQueue_enqAt(queue, (void *) i, later);
+    }
+
+    for (long i = 1; i <= 8; i++) {
+        assert(DelayQueue_deq(queue) == (void *) i);
+    }
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that an element due past the first wheel level is cascaded down and delivered on time.
+ */
+int deqAcrossLevels() {
+    uint64_t start = DelayQueue_nowMs();
+    DelayQueue_enq(queue, (void *) 2, 300);
+    DelayQueue_enq(queue, (void *) 1, 5);
+
+    assert(DelayQueue_deq(queue) == (void *) 1);
+    assert(DelayQueue_deq(queue) == (void *) 2);
+    assert(DelayQueue_nowMs() - start >= 295);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a cancelled element is never dequeued and cannot be cancelled twice.
+ */
+int cancelPending() {
+    DelayTimerId first = DelayQueue_enq(queue, (void *) 1, 10);
+    DelayQueue_enq(queue, (void *) 2, 20);
+
+    assert(DelayQueue_cancel(queue, first) == true);
+    assert(DelayQueue_cancel(queue, first) == false);
+    assert(DelayQueue_cancel(queue, 0) == false);
+    assert(DelayQueue_size(queue) == 1);
+
+    assert(DelayQueue_deq(queue) == (void *) 2);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that an id is no longer valid once its element has been dequeued and the node reused.
+ */
+int cancelAfterDeq() {
+    DelayTimerId id = DelayQueue_enq(queue, (void *) 1, 0);
+    assert(DelayQueue_deq(queue) == (void *) 1);
+    DelayTimerId reused = DelayQueue_enq(queue, (void *) 2, 1000);
+
+    assert(DelayQueue_cancel(queue, id) == false);
+    assert(DelayQueue_size(queue) == 1);
+    assert(DelayQueue_cancel(queue, reused) == true);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Helper function for deqBlocksUntilEnq. Dequeues a single element.
+ */
+void *deqOne(void *arg) {
+    return DelayQueue_deq((DelayQueue *) arg);
+}
+
+/*
+ * Checks that deq on an empty queue blocks until an element is enqueued and becomes due.
+ */
+int deqBlocksUntilEnq() {
+    pthread_t thread;
+    pthread_create(&thread, NULL, deqOne, (void *) queue);
+
+    DelayQueue_enq(queue, (void *) 7, 20);
+
+    void *result;
+    pthread_join(thread, &result);
+    assert(result == (void *) 7);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that many pending timers with widely spread due times can be inserted and cancelled.
+ */
+int manyTimers() {
+    static DelayTimerId ids[MANY_TIMERS];
+    for (long i = 0; i < MANY_TIMERS; i++) {
+        ids[i] = DelayQueue_enq(queue, (void *) (i + 1), 1000 + (uint64_t) i * 997);
+        assert(ids[i] != 0);
+    }
+    assert(DelayQueue_size(queue) == MANY_TIMERS);
+
+    for (long i = 0; i < MANY_TIMERS; i++) {
+        assert(DelayQueue_cancel(queue, ids[i]) == true);
+    }
+    assert(DelayQueue_isEmpty(queue) == true);
+
+    return TEST_SUCCESS;
+}
+
+
+/*
+ * Main function for the DelayQueue tests which will run each user-defined test in turn.
+ */
+
+int main() {
+    runTest(newQueueIsNotNull);
+    runTest(enqNullElement);
+    runTest(elementNotDueEarly);
+    runTest(deqInDueOrder);
+    runTest(sameDueTimeIsFifo);
+    runTest(deqAcrossLevels);
+    runTest(cancelPending);
+    runTest(cancelAfterDeq);
+    runTest(deqBlocksUntilEnq);
+    runTest(manyTimers);
+
+    printf("\nDelayQueue Tests complete: %d / %d tests successful.\n----------------\n", success_count, total_count);
+
+}
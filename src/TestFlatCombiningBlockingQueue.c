@@ -0,0 +1,25 @@
+/*
+ * TestFlatCombiningBlockingQueue.c
+ *
+ * Runs every BlockingQueue test in TestBlockingQueue.c against FlatCombiningBlockingQueue.
+ *
+ */
+
+#include "FlatCombiningBlockingQueue.h"
+
+/* Skip BlockingQueue.h so the names below can be redirected to FlatCombiningBlockingQueue. */
+#define BLOCKING_QUEUE_H_
+
+#define TEST_QUEUE_NAME "FlatCombiningBlockingQueue"
+#define TEST_SKIP_EXTENSIONS
+
+#define BlockingQueue FlatCombiningBlockingQueue
+#define new_BlockingQueue new_FlatCombiningBlockingQueue
+#define BlockingQueue_enq FlatCombiningBlockingQueue_enq
+#define BlockingQueue_deq FlatCombiningBlockingQueue_deq
+#define BlockingQueue_size FlatCombiningBlockingQueue_size
+#define BlockingQueue_isEmpty FlatCombiningBlockingQueue_isEmpty
+#define BlockingQueue_clear FlatCombiningBlockingQueue_clear
+#define BlockingQueue_destroy FlatCombiningBlockingQueue_destroy
+
+#include "TestBlockingQueue.c"
@@ -0,0 +1,15 @@
+/*
+ * TestHandoffBlockingQueue.c
+ *
+ * Runs every BlockingQueue test in TestBlockingQueue.c against a BlockingQueue in handoff mode.
+ *
+ */
+
+#include "BlockingQueue.h"
+
+#define TEST_QUEUE_NAME "HandoffBlockingQueue"
+
+/* The tests' shared queue is created in handoff mode; queues the tests create themselves are unchanged. */
+#define new_BlockingQueue(max_size) new_BlockingQueueHandoff(max_size)
+
+#include "TestBlockingQueue.c"
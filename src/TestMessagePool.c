@@ -0,0 +1,246 @@
+/*
+ * TestMessagePool.c
+ *
+ * Very simple unit test file for MessagePool functionality.
+ *
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "BlockingQueue.h"
+#include "MessagePool.h"
+#include "myassert.h"
+
+
+#define DEFAULT_POOL_SIZE 20
+#define DEFAULT_BUFFER_SIZE 100
+#define NUM_MESSAGES 10000
+
+/*
+ * The pool to use during tests
+ */
+static MessagePool *pool;
+
+/*
+ * The number of tests that succeeded
+ */
+static int success_count = 0;
+
+/*
+ * The total number of tests run
+ */
+static int total_count = 0;
+
+
+/*
+ * Setup function to run prior to each test
+ */
+void setup(){
+    pool = new_MessagePool(DEFAULT_POOL_SIZE, DEFAULT_BUFFER_SIZE);
+    total_count++;
+}
+
+/*
+ * Teardown function to run after each test
+ */
+void teardown(){
+    MessagePool_destroy(pool);
+}
+
+/*
+ * This function is called multiple times from main for each user-defined test function
+ */
+void runTest(int (*testFunction)()) {
+    setup();
+
+    if (testFunction()) success_count++;
+
+    teardown();
+}
+
+
+/*
+ * Checks that the MessagePool constructor returns a non-NULL pointer with all buffers free.
+ */
+int newPoolIsNotNull() {
+    assert(pool != NULL);
+    assert(MessagePool_bufferSize(pool) >= DEFAULT_BUFFER_SIZE);
+
+    MessagePoolStats stats;
+    MessagePool_stats(pool, &stats);
+    assert(stats.available == DEFAULT_POOL_SIZE);
+    assert(stats.exhausted == 0);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that invalid pool sizes are rejected.
+ */
+int newPoolInvalidSize() {
+    assert(new_MessagePool(0, DEFAULT_BUFFER_SIZE) == NULL);
+    assert(new_MessagePool(DEFAULT_POOL_SIZE, 0) == NULL);
+    assert(new_MessagePool(1, SIZE_MAX) == NULL);
+    assert(new_MessagePool(DEFAULT_POOL_SIZE, SIZE_MAX / 2) == NULL);
+    assert(new_MessagePool(DEFAULT_POOL_SIZE, SIZE_MAX / DEFAULT_POOL_SIZE) == NULL);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that every buffer can be acquired, that buffers do not overlap and that the
+ * pool reports exhaustion once empty.
+ */
+int acquireAllThenExhausted() {
+    char *buffers[DEFAULT_POOL_SIZE];
+    for (int i = 0; i < DEFAULT_POOL_SIZE; i++) {
+        buffers[i] = MessagePool_acquire(pool);
+        assert(buffers[i] != NULL);
+        memset(buffers[i], i, DEFAULT_BUFFER_SIZE);
+    }
+    for (int i = 0; i < DEFAULT_POOL_SIZE; i++) {
+        assert(buffers[i][0] == i && buffers[i][DEFAULT_BUFFER_SIZE - 1] == i);
+    }
+
+    assert(MessagePool_acquire(pool) == NULL);
+    assert(MessagePool_acquire(pool) == NULL);
+
+    MessagePoolStats stats;
+    MessagePool_stats(pool, &stats);
+    assert(stats.acquired == DEFAULT_POOL_SIZE);
+    assert(stats.exhausted == 2);
+    assert(stats.available == 0);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a released buffer can be acquired again.
+ */
+int releaseAndReacquire() {
+    void *buffer = MessagePool_acquire(pool);
+    assert(MessagePool_release(pool, buffer) == true);
+    assert(MessagePool_acquire(pool) == buffer);
+
+    MessagePoolStats stats;
+    MessagePool_stats(pool, &stats);
+    assert(stats.acquired == 2);
+    assert(stats.released == 1);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that releasing NULL or a foreign pointer returns false.
+ */
+int releaseForeignBuffer() {
+    int local = 0;
+    assert(MessagePool_release(pool, NULL) == false);
+    assert(MessagePool_release(pool, &local) == false);
+
+    char *buffer = MessagePool_acquire(pool);
+    assert(MessagePool_release(pool, buffer + 1) == false);
+    assert(MessagePool_release(pool, buffer) == true);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a cache hands out pool buffers and returns them all when destroyed.
+ */
+int cacheAcquireAndRelease() {
+    MessagePoolCache *cache = new_MessagePoolCache(pool, 8);
+    assert(cache != NULL);
+
+    void *buffers[DEFAULT_POOL_SIZE];
+    for (int i = 0; i < DEFAULT_POOL_SIZE; i++) {
+        buffers[i] = MessagePoolCache_acquire(cache);
+        assert(buffers[i] != NULL);
+    }
+    assert(MessagePoolCache_acquire(cache) == NULL);
+
+    for (int i = 0; i < DEFAULT_POOL_SIZE; i++) {
+        assert(MessagePoolCache_release(cache, buffers[i]) == true);
+    }
+    assert(cache->size <= 8);
+
+    MessagePoolCache_destroy(cache);
+
+    MessagePoolStats stats;
+    MessagePool_stats(pool, &stats);
+    assert(stats.available == DEFAULT_POOL_SIZE);
+    assert(stats.exhausted == 1);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Helper function for concurrentPoolMessaging. Consumes messages and returns their buffers.
+ */
+void *consumeMessages(void *arg) {
+    BlockingQueue *messages = (BlockingQueue *) arg;
+    for (int i = 0; i < NUM_MESSAGES; i++) {
+        int *message = BlockingQueue_deq(messages);
+        if (*message != i) {
+            return (void *) ASSERTION_FAILURE;
+        }
+        MessagePool_release(pool, message);
+    }
+    return (void *) TEST_SUCCESS;
+}
+
+/*
+ * Checks that buffers flow from a producer to a consumer thread and back to the pool.
+ */
+int concurrentPoolMessaging() {
+    BlockingQueue *messages = new_BlockingQueue(DEFAULT_POOL_SIZE);
+    MessagePoolCache *cache = new_MessagePoolCache(pool, 4);
+    pthread_t thread;
+    pthread_create(&thread, NULL, consumeMessages, (void *) messages);
+
+    for (int i = 0; i < NUM_MESSAGES; i++) {
+        int *message;
+        while ((message = MessagePoolCache_acquire(cache)) == NULL) {
+            sched_yield();
+        }
+        *message = i;
+        BlockingQueue_enq(messages, message);
+    }
+
+    void *result;
+    pthread_join(thread, &result);
+    MessagePoolCache_destroy(cache);
+    BlockingQueue_destroy(messages);
+    assert(result == (void *) TEST_SUCCESS);
+
+    MessagePoolStats stats;
+    MessagePool_stats(pool, &stats);
+    assert(stats.acquired == NUM_MESSAGES);
+    assert(stats.released == NUM_MESSAGES);
+    assert(stats.available == DEFAULT_POOL_SIZE);
+
+    return TEST_SUCCESS;
+}
+
+
+/*
+ * Main function for the MessagePool tests which will run each user-defined test in turn.
+ */
+
+int main() {
+    runTest(newPoolIsNotNull);
+    runTest(newPoolInvalidSize);
+    runTest(acquireAllThenExhausted);
+    runTest(releaseAndReacquire);
+    runTest(releaseForeignBuffer);
+    runTest(cacheAcquireAndRelease);
+    runTest(concurrentPoolMessaging);
+
+    printf("\nMessagePool Tests complete: %d / %d tests successful.\n----------------\n", success_count, total_count);
+
+}
@@ -0,0 +1,261 @@
+/*
+ * TestPipeline.c
+ *
+ * Very simple unit test file for Pipeline functionality.
+ *
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "Pipeline.h"
+#include "myassert.h"
+
+
+#define DEFAULT_BATCH_SIZE 16
+#define DEFAULT_QUEUE_SIZE 64
+#define NUM_ELEMENTS 20000
+#define NUM_SLOW_ELEMENTS 200
+
+/*
+ * The pipeline to use during tests
+ */
+static Pipeline *pipeline;
+
+/*
+ * The number of tests that succeeded
+ */
+static int success_count = 0;
+
+/*
+ * The total number of tests run
+ */
+static int total_count = 0;
+
+/*
+ * Sum and count of the elements reaching the sink stage, and whether they arrived in order.
+ */
+static atomic_long sinkSum;
+static atomic_long sinkCount;
+static long lastSeen;
+static bool inOrder;
+
+
+/*
+ * Setup function to run prior to each test
+ */
+void setup(){
+    pipeline = new_Pipeline(DEFAULT_BATCH_SIZE);
+    atomic_store(&sinkSum, 0);
+    atomic_store(&sinkCount, 0);
+    lastSeen = 0;
+    inOrder = true;
+    total_count++;
+}
+
+/*
+ * Teardown function to run after each test
+ */
+void teardown(){
+    Pipeline_destroy(pipeline);
+}
+
+/*
+ * This function is called multiple times from main for each user-defined test function
+ */
+void runTest(int (*testFunction)()) {
+    setup();
+
+    if (testFunction()) success_count++;
+
+    teardown();
+}
+
+/*
+ * Stage functions over long values carried in the element pointers.
+ */
+void *addOne(void *element, void *arg) {
+    (void) arg;
+    return (void *) ((long) element + 1);
+}
+
+void *doubleValue(void *element, void *arg) {
+    (void) arg;
+    return (void *) ((long) element * 2);
+}
+
+void *keepEven(void *element, void *arg) {
+    (void) arg;
+    return (long) element % 2 == 0 ? element : NULL;
+}
+
+void *sleepThenPass(void *element, void *arg) {
+    usleep((useconds_t) (long) arg);
+    return element;
+}
+
+void *sink(void *element, void *arg) {
+    (void) arg;
+    atomic_fetch_add(&sinkSum, (long) element);
+    atomic_fetch_add(&sinkCount, 1);
+    return NULL;
+}
+
+void *orderedSink(void *element, void *arg) {
+    if ((long) element <= lastSeen) {
+        inOrder = false;
+    }
+    lastSeen = (long) element;
+    return sink(element, arg);
+}
+
+
+/*
+ * Checks that the Pipeline constructor returns a non-NULL pointer and that invalid use is refused.
+ */
+int newPipelineIsNotNull() {
+    assert(pipeline != NULL);
+    assert(new_Pipeline(0) == NULL);
+    assert(Pipeline_start(pipeline) == false);
+    assert(Pipeline_submit(pipeline, (void *) 1) == false);
+
+    assert(Pipeline_addStage(pipeline, "none", NULL, NULL, 1, DEFAULT_QUEUE_SIZE) == -1);
+    assert(Pipeline_addStage(pipeline, "idle", sink, NULL, 0, DEFAULT_QUEUE_SIZE) == -1);
+    assert(Pipeline_addStage(pipeline, "unbuffered", sink, NULL, 1, 0) == -1);
+    assert(Pipeline_addStage(pipeline, "sink", sink, NULL, 1, DEFAULT_QUEUE_SIZE) == 0);
+
+    assert(Pipeline_start(pipeline) == true);
+    assert(Pipeline_start(pipeline) == false);
+    assert(Pipeline_addStage(pipeline, "late", sink, NULL, 1, DEFAULT_QUEUE_SIZE) == -1);
+    assert(Pipeline_submit(pipeline, NULL) == false);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that every element passes through parallel stages and that close drains them all.
+ */
+int elementsFlowThroughStages() {
+    assert(Pipeline_addStage(pipeline, "addOne", addOne, NULL, 2, DEFAULT_QUEUE_SIZE) == 0);
+    assert(Pipeline_addStage(pipeline, "double", doubleValue, NULL, 3, DEFAULT_QUEUE_SIZE) == 1);
+    assert(Pipeline_addStage(pipeline, "sink", sink, NULL, 1, DEFAULT_QUEUE_SIZE) == 2);
+    assert(Pipeline_start(pipeline) == true);
+
+    for (long i = 1; i <= NUM_ELEMENTS; i++) {
+        assert(Pipeline_submit(pipeline, (void *) i) == true);
+    }
+    Pipeline_close(pipeline);
+    assert(Pipeline_submit(pipeline, (void *) 1) == false);
+
+    long expected = 0;
+    for (long i = 1; i <= NUM_ELEMENTS; i++) {
+        expected += 2 * (i + 1);
+    }
+    assert(atomic_load(&sinkCount) == NUM_ELEMENTS);
+    assert(atomic_load(&sinkSum) == expected);
+
+    for (int s = 0; s < 3; s++) {
+        PipelineStageStats stats;
+        assert(Pipeline_stats(pipeline, s, &stats) == true);
+        assert(stats.processed == NUM_ELEMENTS);
+        assert(stats.queueDepth == 0);
+        assert(stats.batches >= NUM_ELEMENTS / DEFAULT_BATCH_SIZE);
+    }
+    PipelineStageStats stats;
+    assert(Pipeline_stats(pipeline, 3, &stats) == false);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a stage returning NULL filters the element out of the rest of the pipeline.
+ */
+int nullResultFiltersElement() {
+    Pipeline_addStage(pipeline, "keepEven", keepEven, NULL, 2, DEFAULT_QUEUE_SIZE);
+    Pipeline_addStage(pipeline, "sink", sink, NULL, 2, DEFAULT_QUEUE_SIZE);
+    Pipeline_start(pipeline);
+
+    for (long i = 1; i <= NUM_ELEMENTS; i++) {
+        Pipeline_submit(pipeline, (void *) i);
+    }
+    Pipeline_close(pipeline);
+
+    PipelineStageStats stats;
+    Pipeline_stats(pipeline, 1, &stats);
+    assert(stats.processed == NUM_ELEMENTS / 2);
+    assert(atomic_load(&sinkCount) == NUM_ELEMENTS / 2);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that single-worker stages keep submission order, including for batched submits.
+ */
+int singleWorkersKeepOrder() {
+    Pipeline_addStage(pipeline, "addOne", addOne, NULL, 1, DEFAULT_QUEUE_SIZE);
+    Pipeline_addStage(pipeline, "sink", orderedSink, NULL, 1, DEFAULT_QUEUE_SIZE);
+    Pipeline_start(pipeline);
+
+    void *batch[DEFAULT_BATCH_SIZE];
+    for (long i = 0; i < NUM_ELEMENTS / DEFAULT_BATCH_SIZE; i++) {
+        for (long j = 0; j < DEFAULT_BATCH_SIZE; j++) {
+            batch[j] = (void *) (i * DEFAULT_BATCH_SIZE + j + 1);
+        }
+        assert(Pipeline_submitBatch(pipeline, batch, DEFAULT_BATCH_SIZE) == DEFAULT_BATCH_SIZE);
+    }
+    Pipeline_close(pipeline);
+
+    assert(atomic_load(&sinkCount) == NUM_ELEMENTS);
+    assert(inOrder == true);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that the statistics single out a slow stage and show its neighbours waiting on it.
+ */
+int statsFindBottleneck() {
+    Pipeline_addStage(pipeline, "fast", addOne, NULL, 1, 4);
+    Pipeline_addStage(pipeline, "slow", sleepThenPass, (void *) 200L, 1, 4);
+    Pipeline_addStage(pipeline, "sink", sink, NULL, 1, 4);
+    Pipeline_start(pipeline);
+
+    for (long i = 1; i <= NUM_SLOW_ELEMENTS; i++) {
+        Pipeline_submit(pipeline, (void *) i);
+    }
+    Pipeline_close(pipeline);
+
+    PipelineStageStats fast;
+    PipelineStageStats slow;
+    PipelineStageStats last;
+    Pipeline_stats(pipeline, 0, &fast);
+    Pipeline_stats(pipeline, 1, &slow);
+    Pipeline_stats(pipeline, 2, &last);
+
+    assert(Pipeline_bottleneck(pipeline) == 1);
+    assert(slow.busySeconds >= NUM_SLOW_ELEMENTS * 200e-6);
+    assert(slow.busySeconds > fast.busySeconds);
+    assert(fast.blockedSeconds > fast.busySeconds);
+    assert(last.waitSeconds > last.busySeconds);
+    assert(slow.throughput > 0);
+
+    return TEST_SUCCESS;
+}
+
+
+/*
+ * Main function for the Pipeline tests which will run each user-defined test in turn.
+ */
+
+int main() {
+    runTest(newPipelineIsNotNull);
+    runTest(elementsFlowThroughStages);
+    runTest(nullResultFiltersElement);
+    runTest(singleWorkersKeepOrder);
+    runTest(statsFindBottleneck);
+
+    printf("\nPipeline Tests complete: %d / %d tests successful.\n----------------\n", success_count, total_count);
+
+}
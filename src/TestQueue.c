@@ -7,12 +7,17 @@
 
 #include <stdio.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #include "myassert.h"
 #include "Queue.h"
+#include "QueueInline.h"
+#include "ReservedRing.h"
 
 
 #define DEFAULT_MAX_QUEUE_SIZE 20
+#define HUGE_QUEUE_SIZE ((size_t) 1 << 32)
+#define HUGE_QUEUE_DEPTH 1000000
 
 /*
  * The queue to use during tests
@@ -224,7 +229,95 @@ int queueClearEmpty() {
     return TEST_SUCCESS;
 }
 
+/*
+ * Checks that the inline fast path behaves the same as the out-of-line functions.
+ */
+int inlineEnqAndDeq() {
+    assert(QueueInline_isEmpty(queue) == true);
+    assert(QueueInline_enq(queue, NULL) == false);
+    assert(QueueInline_enq(queue, (void *) 1) == true);
+    assert(Queue_enq(queue, (void *) 2) == true);
+    assert(QueueInline_size(queue) == 2);
+
+    assert(QueueInline_deq(queue) == (void *) 1);
+    assert(Queue_deq(queue) == (void *) 2);
+    assert(QueueInline_deq(queue) == NULL);
+
+    for (int i = 1; i <= DEFAULT_MAX_QUEUE_SIZE; i++) {
+        assert(QueueInline_enq(queue, (void *) 1) == true);
+    }
+    assert(QueueInline_enq(queue, (void *) 2) == false);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that elements wrap around the end of the ring in FIFO order.
+ */
+int enqDeqWrapAround() {
+    for (long round = 0; round < 3; round++) {
+        for (long i = 1; i <= DEFAULT_MAX_QUEUE_SIZE - 5; i++) {
+            assert(Queue_enq(queue, (void *) i) == true);
+        }
+        for (long i = 1; i <= DEFAULT_MAX_QUEUE_SIZE - 5; i++) {
+            assert(Queue_deq(queue) == (void *) i);
+        }
+    }
+    assert(Queue_isEmpty(queue) == true);
+
+    return TEST_SUCCESS;
+}
 
+/*
+ * Checks that a reserved queue with billions of slots only keeps the occupied part resident.
+ */
+int reservedQueueTracksDepth() {
+    Queue *huge = new_QueueReserved(HUGE_QUEUE_SIZE);
+    assert(huge != NULL);
+    assert(ReservedRing_residentBytes(huge->array, huge->maxSize) == 0);
+
+    for (long i = 1; i <= HUGE_QUEUE_DEPTH; i++) {
+        assert(Queue_enq(huge, (void *) i) == true);
+    }
+    assert(Queue_size(huge) == HUGE_QUEUE_DEPTH);
+    size_t resident = ReservedRing_residentBytes(huge->array, huge->maxSize);
+    assert(resident >= HUGE_QUEUE_DEPTH * sizeof(void*));
+    assert(resident < 2 * HUGE_QUEUE_DEPTH * sizeof(void*));
+
+    for (long i = 1; i <= HUGE_QUEUE_DEPTH; i++) {
+        assert(Queue_deq(huge) == (void *) i);
+    }
+    resident = ReservedRing_residentBytes(huge->array, huge->maxSize);
+    assert(resident <= 2 * RESERVED_RING_BATCH_SLOTS * sizeof(void*));
+
+    Queue_destroy(huge);
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a reserved ring cycling within the retain window keeps its pages between laps,
+ * and that a capacity whose slot array would overflow size_t is refused.
+ */
+int reservedQueueKeepsCyclingPages() {
+    assert(new_Queue(SIZE_MAX / sizeof(void*) + 1) == NULL);
+    assert(new_QueueReserved(SIZE_MAX / sizeof(void*) + 1) == NULL);
+
+    size_t slots = RESERVED_RING_RETAIN_SLOTS / 2;
+    Queue *ring = new_QueueReserved(slots);
+    assert(ring != NULL);
+
+    long next = 1;
+    for (size_t i = 0; i < 3 * slots; i++) {
+        assert(Queue_enq(ring, (void *) next++) == true);
+        if (Queue_size(ring) > 100) {
+            Queue_deq(ring);
+        }
+    }
+    assert(ReservedRing_residentBytes(ring->array, ring->maxSize) >= slots * sizeof(void*));
+
+    Queue_destroy(ring);
+    return TEST_SUCCESS;
+}
 
 
 /*
@@ -249,6 +342,10 @@ int main() {
     runTest(queueEmpty);
     runTest(queueClear);
     runTest(queueClearEmpty);
+    runTest(inlineEnqAndDeq);
+    runTest(enqDeqWrapAround);
+    runTest(reservedQueueTracksDepth);
+    runTest(reservedQueueKeepsCyclingPages);
     /*
      * you will have to call runTest on all your test functions above, such as
      *
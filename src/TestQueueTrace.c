@@ -0,0 +1,344 @@
+/*
+ * TestQueueTrace.c
+ *
+ * Very simple unit test file for QueueTrace recording and QueueReplay.
+ *
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "BlockingQueue.h"
+#include "QueueReplay.h"
+#include "QueueTrace.h"
+#include "myassert.h"
+
+
+#define DEFAULT_MAX_QUEUE_SIZE 20
+#define NUM_THREADS 4
+#define NUM_ELEMENTS 10000
+#define TRACE_FILE "TestQueueTrace.trace"
+
+/*
+ * The queue to use during tests
+ */
+static BlockingQueue *queue;
+
+/*
+ * The number of tests that succeeded
+ */
+static int success_count = 0;
+
+/*
+ * The total number of tests run
+ */
+static int total_count = 0;
+
+
+/*
+ * Setup function to run prior to each test
+ */
+void setup(){
+    queue = new_BlockingQueue(DEFAULT_MAX_QUEUE_SIZE);
+    total_count++;
+}
+
+/*
+ * Teardown function to run after each test
+ */
+void teardown(){
+    QueueTrace_stop();
+    BlockingQueue_destroy(queue);
+}
+
+/*
+ * This function is called multiple times from main for each user-defined test function
+ */
+void runTest(int (*testFunction)()) {
+    setup();
+
+    if (testFunction()) success_count++;
+
+    teardown();
+}
+
+static void *createBlockingQueue(size_t max_size) {
+    return new_BlockingQueue(max_size);
+}
+
+static bool enqBlockingQueue(void *target, void *element) {
+    return BlockingQueue_enq(target, element);
+}
+
+static void *deqBlockingQueue(void *target) {
+    return BlockingQueue_deq(target);
+}
+
+static void destroyBlockingQueue(void *target) {
+    BlockingQueue_destroy(target);
+}
+
+static const QueueReplayOps blockingQueueOps = {
+    "BlockingQueue", createBlockingQueue, enqBlockingQueue, deqBlockingQueue, destroyBlockingQueue
+};
+
+/*
+ * Helper function for traced threads. Enqueues and dequeues NUM_ELEMENTS elements in turn.
+ */
+void *enqDeqElements(void *arg) {
+    BlockingQueue *target = (BlockingQueue *) arg;
+    for (long i = 1; i <= NUM_ELEMENTS; i++) {
+        BlockingQueue_enq(target, (void *) i);
+        BlockingQueue_deq(target);
+    }
+    return NULL;
+}
+
+/*
+ * Helper function for recordsBlockedDeq. Dequeues one element.
+ */
+void *deqOneElement(void *arg) {
+    return BlockingQueue_deq((BlockingQueue *) arg);
+}
+
+
+/*
+ * Checks that nothing is recorded unless tracing is started, or after it is stopped.
+ */
+int nothingRecordedWhenStopped() {
+    size_t count;
+    QueueTrace_start();
+    QueueTrace_stop();
+    BlockingQueue_enq(queue, (void *) 1);
+    BlockingQueue_deq(queue);
+
+    QueueTraceEvent *events = QueueTrace_collect(&count);
+    assert(events == NULL);
+    assert(count == 0);
+    assert(QueueTrace_enabled() == false);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that enqueues and dequeues are recorded in order with the queue and thread.
+ */
+int recordsEnqAndDeq() {
+    QueueTrace_start();
+    BlockingQueue_enq(queue, (void *) 1);
+    void *batch[2] = { (void *) 2, (void *) 3 };
+    BlockingQueue_enqBatch(queue, batch, 2);
+    BlockingQueue_deq(queue);
+    BlockingQueue_deqBatch(queue, batch, 2);
+    QueueTrace_stop();
+
+    size_t count;
+    QueueTraceEvent *events = QueueTrace_collect(&count);
+    assert(count == 6);
+    for (size_t i = 0; i < count; i++) {
+        assert(events[i].type == (i < 3 ? QUEUE_TRACE_ENQ : QUEUE_TRACE_DEQ));
+        assert(events[i].queue == (uint64_t) (uintptr_t) queue);
+        assert(events[i].thread == 0);
+        assert(i == 0 || events[i].timestampNs >= events[i - 1].timestampNs);
+    }
+    free(events);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that clearing a queue and evicting from a DROP_OLDEST queue record no dequeues,
+ * so a replay does not turn them into dequeues by the clearing or producing thread.
+ */
+int clearAndEvictionRecordNoDeq() {
+    BlockingQueue *dropping = new_BlockingQueueWithPolicy(1, BLOCKING_QUEUE_DROP_OLDEST, NULL);
+    QueueTrace_start();
+    BlockingQueue_enq(queue, (void *) 1);
+    BlockingQueue_enq(queue, (void *) 2);
+    BlockingQueue_clear(queue);
+    BlockingQueue_enq(dropping, (void *) 3);
+    BlockingQueue_enq(dropping, (void *) 4);
+    QueueTrace_stop();
+
+    size_t count;
+    QueueTraceEvent *events = QueueTrace_collect(&count);
+    assert(count == 4);
+    for (size_t i = 0; i < count; i++) {
+        assert(events[i].type == QUEUE_TRACE_ENQ);
+    }
+    free(events);
+    assert(BlockingQueue_isEmpty(queue) == true);
+    assert(BlockingQueue_deq(dropping) == (void *) 4);
+    BlockingQueue_destroy(dropping);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a dequeue on an empty queue records a block event before the dequeue itself.
+ */
+int recordsBlockedDeq() {
+    QueueTrace_start();
+    pthread_t thread;
+    pthread_create(&thread, NULL, deqOneElement, (void *) queue);
+    usleep(1000);
+    BlockingQueue_enq(queue, (void *) 1);
+    pthread_join(thread, NULL);
+    QueueTrace_stop();
+
+    size_t count;
+    QueueTraceEvent *events = QueueTrace_collect(&count);
+    assert(count == 3);
+    assert(events[0].type == QUEUE_TRACE_BLOCK_DEQ);
+    assert(events[1].type == QUEUE_TRACE_ENQ);
+    assert(events[2].type == QUEUE_TRACE_DEQ);
+    assert(events[0].thread == events[2].thread);
+    assert(events[0].thread != events[1].thread);
+    free(events);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that per-thread buffers from many threads merge into one ordered trace.
+ */
+int mergesThreadBuffers() {
+    QueueTrace_start();
+    pthread_t threads[NUM_THREADS];
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_create(&threads[i], NULL, enqDeqElements, (void *) queue);
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    QueueTrace_stop();
+
+    size_t count;
+    QueueTraceEvent *events = QueueTrace_collect(&count);
+    size_t operations = 0;
+    long perThread[NUM_THREADS] = {0};
+    for (size_t i = 0; i < count; i++) {
+        assert(i == 0 || events[i].timestampNs >= events[i - 1].timestampNs);
+        assert(events[i].thread < NUM_THREADS);
+        if (events[i].type == QUEUE_TRACE_ENQ || events[i].type == QUEUE_TRACE_DEQ) {
+            operations++;
+            perThread[events[i].thread]++;
+        }
+    }
+    assert(operations == 2 * NUM_THREADS * NUM_ELEMENTS);
+    for (int i = 0; i < NUM_THREADS; i++) {
+        assert(perThread[i] == 2 * NUM_ELEMENTS);
+    }
+    free(events);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a saved trace loads back unchanged and that bad files are refused.
+ */
+int saveAndLoadRoundTrip() {
+    QueueTrace_start();
+    for (long i = 1; i <= DEFAULT_MAX_QUEUE_SIZE; i++) {
+        BlockingQueue_enq(queue, (void *) i);
+    }
+    QueueTrace_stop();
+
+    size_t count;
+    QueueTraceEvent *events = QueueTrace_collect(&count);
+    assert(QueueTrace_save(TRACE_FILE, events, count) == true);
+
+    size_t loadedCount;
+    QueueTraceEvent *loaded = QueueTrace_load(TRACE_FILE, &loadedCount);
+    assert(loaded != NULL);
+    assert(loadedCount == count);
+    for (size_t i = 0; i < count; i++) {
+        assert(loaded[i].timestampNs == events[i].timestampNs);
+        assert(loaded[i].queue == events[i].queue);
+        assert(loaded[i].thread == events[i].thread);
+        assert(loaded[i].type == events[i].type);
+    }
+    free(loaded);
+    free(events);
+    remove(TRACE_FILE);
+
+    assert(QueueTrace_load(TRACE_FILE, &loadedCount) == NULL);
+    assert(loadedCount == 0);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that replaying a recorded trace performs every traced operation.
+ */
+int replayRecordedTrace() {
+    QueueTrace_start();
+    pthread_t threads[NUM_THREADS];
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_create(&threads[i], NULL, enqDeqElements, (void *) queue);
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    QueueTrace_stop();
+
+    size_t count;
+    QueueTraceEvent *events = QueueTrace_collect(&count);
+    QueueReplayResult result;
+    assert(QueueReplay_run(events, count, &blockingQueueOps, DEFAULT_MAX_QUEUE_SIZE, true, &result) == true);
+    assert(result.operations == 2 * NUM_THREADS * NUM_ELEMENTS);
+    assert(result.threads == NUM_THREADS);
+    assert(result.queues == 1);
+    assert(result.throughput > 0);
+    assert(result.latencyP50Ns <= result.latencyP99Ns);
+    assert(result.latencyP99Ns <= result.latencyMaxNs);
+    free(events);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a trace starting mid-stream, with dequeues of elements enqueued before it
+ * began and elements left over at its end, replays without waiting forever.
+ */
+int replayPartialTrace() {
+    QueueTraceEvent events[] = {
+        { 100, 1, 0, QUEUE_TRACE_DEQ },
+        { 200, 1, 0, QUEUE_TRACE_DEQ },
+        { 300, 1, 1, QUEUE_TRACE_ENQ },
+        { 400, 1, 1, QUEUE_TRACE_BLOCK_ENQ },
+        { 500, 1, 1, QUEUE_TRACE_ENQ },
+        { 600, 1, 1, QUEUE_TRACE_ENQ },
+        { 700, 1, 1, QUEUE_TRACE_ENQ },
+    };
+    QueueReplayResult result;
+    assert(QueueReplay_run(events, 7, &blockingQueueOps, 1, false, &result) == true);
+    assert(result.operations == 6);
+    assert(result.threads == 2);
+
+    assert(QueueReplay_run(events + 3, 1, &blockingQueueOps, 1, false, &result) == false);
+
+    return TEST_SUCCESS;
+}
+
+
+/*
+ * Main function for the QueueTrace tests which will run each user-defined test in turn.
+ */
+
+int main() {
+    runTest(nothingRecordedWhenStopped);
+    runTest(recordsEnqAndDeq);
+    runTest(clearAndEvictionRecordNoDeq);
+    runTest(recordsBlockedDeq);
+    runTest(mergesThreadBuffers);
+    runTest(saveAndLoadRoundTrip);
+    runTest(replayRecordedTrace);
+    runTest(replayPartialTrace);
+
+    printf("\nQueueTrace Tests complete: %d / %d tests successful.\n----------------\n", success_count, total_count);
+
+}
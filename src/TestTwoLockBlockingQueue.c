@@ -0,0 +1,25 @@
+/*
+ * TestTwoLockBlockingQueue.c
+ *
+ * Runs every BlockingQueue test in TestBlockingQueue.c against TwoLockBlockingQueue.
+ *
+ */
+
+#include "TwoLockBlockingQueue.h"
+
+/* Skip BlockingQueue.h so the names below can be redirected to TwoLockBlockingQueue. */
+#define BLOCKING_QUEUE_H_
+
+#define TEST_QUEUE_NAME "TwoLockBlockingQueue"
+#define TEST_SKIP_EXTENSIONS
+
+#define BlockingQueue TwoLockBlockingQueue
+#define new_BlockingQueue new_TwoLockBlockingQueue
+#define BlockingQueue_enq TwoLockBlockingQueue_enq
+#define BlockingQueue_deq TwoLockBlockingQueue_deq
+#define BlockingQueue_size TwoLockBlockingQueue_size
+#define BlockingQueue_isEmpty TwoLockBlockingQueue_isEmpty
+#define BlockingQueue_clear TwoLockBlockingQueue_clear
+#define BlockingQueue_destroy TwoLockBlockingQueue_destroy
+
+#include "TestBlockingQueue.c"
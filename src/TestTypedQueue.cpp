@@ -0,0 +1,423 @@
+/*
+ * TestTypedQueue.cpp
+ *
+ * Very simple unit test file for the typed::Queue, typed::BlockingQueue and typed::FixedQueue templates.
+ *
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+
+#include "TypedQueue.hpp"
+#include "myassert.h"
+
+
+#define DEFAULT_MAX_QUEUE_SIZE 20
+#define NUM_ELEMENTS 10000
+#define NUM_THREADS 4
+
+/*
+ * The number of tests that succeeded
+ */
+static int success_count = 0;
+
+/*
+ * The total number of tests run
+ */
+static int total_count = 0;
+
+/*
+ * Number of calls to the global operator new since the program started.
+ */
+static std::atomic<size_t> allocations(0);
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size > 0 ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+/*
+ * Element type counting how often it is constructed, copied, moved and destroyed.
+ */
+struct Tracked {
+    static int live;
+    static int copies;
+    static int moves;
+
+    int value;
+
+    explicit Tracked(int v) : value(v) {
+        live++;
+    }
+
+    Tracked(const Tracked& other) : value(other.value) {
+        live++;
+        copies++;
+    }
+
+    Tracked(Tracked&& other) noexcept : value(other.value) {
+        live++;
+        moves++;
+    }
+
+    ~Tracked() {
+        live--;
+    }
+
+    static void reset() {
+        live = 0;
+        copies = 0;
+        moves = 0;
+    }
+};
+
+int Tracked::live = 0;
+int Tracked::copies = 0;
+int Tracked::moves = 0;
+
+/*
+ * Lets a test hold a Gated element's construction, and so its slot, in the middle of a push.
+ */
+struct Gate {
+    std::atomic<bool> entered{false};
+    std::atomic<bool> open{false};
+};
+
+struct Gated {
+    int value;
+
+    Gated(int v, Gate* gate) : value(v) {
+        gate->entered = true;
+        while (!gate->open) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+/*
+ * True when FixedQueue accepts capacity N.
+ */
+template <size_t N>
+concept FixedCapacity = requires { typename typed::FixedQueue<int, N>; };
+
+static_assert(FixedCapacity<1> && FixedCapacity<64>);
+static_assert(!FixedCapacity<0> && !FixedCapacity<3> && !FixedCapacity<100>);
+
+/*
+ * Constant-initialised global queue, usable before main and without a constructor call.
+ */
+constinit static typed::FixedQueue<Tracked, 8> globalQueue;
+
+/*
+ * This function is called multiple times from main for each user-defined test function
+ */
+void runTest(int (*testFunction)()) {
+    total_count++;
+    Tracked::reset();
+
+    if (testFunction()) success_count++;
+}
+
+
+/*
+ * Checks that a Queue<T> keeps FIFO order and reports full and empty like the C Queue.
+ */
+int queueFifoAndBounds() {
+    typed::Queue<int> queue(DEFAULT_MAX_QUEUE_SIZE);
+    assert(queue.empty());
+    assert(queue.capacity() == DEFAULT_MAX_QUEUE_SIZE);
+    assert(!queue.try_pop().has_value());
+
+    for (int i = 1; i <= DEFAULT_MAX_QUEUE_SIZE; i++) {
+        assert(queue.push(i));
+    }
+    assert(!queue.push(DEFAULT_MAX_QUEUE_SIZE + 1));
+    assert(queue.size() == DEFAULT_MAX_QUEUE_SIZE);
+
+    for (int i = 1; i <= DEFAULT_MAX_QUEUE_SIZE; i++) {
+        assert(queue.try_pop() == i);
+    }
+    assert(queue.empty());
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that emplace constructs in place and pop moves exactly once, without copies.
+ */
+int emplaceAndPopWithoutCopies() {
+    typed::BlockingQueue<Tracked> queue(DEFAULT_MAX_QUEUE_SIZE);
+    queue.emplace(1);
+    queue.emplace(2);
+    assert(Tracked::copies == 0);
+    assert(Tracked::moves == 0);
+    assert(Tracked::live == 2);
+
+    Tracked first = queue.pop();
+    assert(first.value == 1);
+    assert(Tracked::copies == 0);
+    assert(Tracked::moves == 1);
+
+    std::optional<Tracked> second = queue.try_pop();
+    assert(second.has_value() && second->value == 2);
+    assert(Tracked::copies == 0);
+    assert(Tracked::moves == 2);
+    assert(!queue.try_pop().has_value());
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that push and pop make no heap allocations once the queue exists.
+ */
+int pushPopWithoutAllocations() {
+    typed::BlockingQueue<std::string> queue(DEFAULT_MAX_QUEUE_SIZE);
+    std::string value = "short";
+
+    size_t before = allocations;
+    for (int i = 0; i < NUM_ELEMENTS; i++) {
+        queue.push(std::move(value));
+        value = queue.pop();
+    }
+    assert(allocations == before);
+    assert(value == "short");
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that move-only types can be queued.
+ */
+int moveOnlyElements() {
+    typed::BlockingQueue<std::unique_ptr<int>> queue(DEFAULT_MAX_QUEUE_SIZE);
+    queue.push(std::make_unique<int>(7));
+    assert(queue.try_emplace(new int(8)));
+
+    std::unique_ptr<int> first = queue.pop();
+    assert(*first == 7);
+    assert(**queue.try_pop() == 8);
+
+    typed::Queue<std::unique_ptr<int>> plain(1);
+    assert(plain.push(std::make_unique<int>(9)));
+    assert(!plain.push(std::make_unique<int>(10)));
+    assert(**plain.try_pop() == 9);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that destroying a queue destroys the elements still in it.
+ */
+int destroyReleasesElements() {
+    {
+        typed::BlockingQueue<Tracked> queue(DEFAULT_MAX_QUEUE_SIZE);
+        typed::Queue<Tracked> plain(DEFAULT_MAX_QUEUE_SIZE);
+        for (int i = 0; i < 5; i++) {
+            queue.emplace(i);
+            plain.emplace(i);
+        }
+        assert(Tracked::live == 10);
+    }
+    assert(Tracked::live == 0);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that try_emplace fails on a full queue and that push blocks until a pop makes space.
+ */
+int pushBlocksWhenFull() {
+    typed::BlockingQueue<int> queue(2);
+    queue.push(1);
+    queue.push(2);
+    assert(!queue.try_emplace(3));
+
+    std::thread producer([&queue] { queue.push(3); });
+    assert(queue.pop() == 1);
+    producer.join();
+
+    assert(queue.pop() == 2);
+    assert(queue.pop() == 3);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a slot vacated ahead of one still being pushed into is reused, so try_emplace
+ * only fails once capacity elements are in the queue or being pushed.
+ */
+int tryEmplaceAfterOutOfOrderPop() {
+    typed::BlockingQueue<Gated> queue(2);
+    Gate slow;
+    Gate fast;
+    fast.open = true;
+
+    std::thread producer([&queue, &slow] { queue.emplace(1, &slow); });
+    while (!slow.entered) {
+        std::this_thread::yield();
+    }
+    queue.emplace(2, &fast);
+    assert(queue.pop().value == 2);
+
+    assert(queue.size() == 0);
+    assert(queue.try_emplace(3, &fast));
+    assert(!queue.try_emplace(4, &fast));
+
+    slow.open = true;
+    producer.join();
+    assert(queue.pop().value == 3);
+    assert(queue.pop().value == 1);
+    assert(queue.empty());
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that several producers and consumers sharing a small queue pass every element exactly once.
+ */
+int concurrentProducersAndConsumers() {
+    typed::BlockingQueue<std::unique_ptr<int>> queue(2);
+    std::atomic<long> sum(0);
+    std::thread producers[NUM_THREADS];
+    std::thread consumers[NUM_THREADS];
+    for (int t = 0; t < NUM_THREADS; t++) {
+        producers[t] = std::thread([&queue] {
+            for (int i = 1; i <= NUM_ELEMENTS; i++) {
+                if (i % 2 == 0 || !queue.try_emplace(std::make_unique<int>(i))) {
+                    queue.push(std::make_unique<int>(i));
+                }
+            }
+        });
+        consumers[t] = std::thread([&queue, &sum] {
+            for (int i = 0; i < NUM_ELEMENTS; i++) {
+                sum += *queue.pop();
+            }
+        });
+    }
+
+    for (int t = 0; t < NUM_THREADS; t++) {
+        producers[t].join();
+        consumers[t].join();
+    }
+    assert(sum == (long) NUM_THREADS * NUM_ELEMENTS * (NUM_ELEMENTS + 1) / 2);
+    assert(queue.empty());
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that elements pass between threads in order.
+ */
+int concurrentProducerConsumer() {
+    typed::BlockingQueue<std::unique_ptr<int>> queue(DEFAULT_MAX_QUEUE_SIZE);
+    std::thread producer([&queue] {
+        for (int i = 1; i <= NUM_ELEMENTS; i++) {
+            queue.push(std::make_unique<int>(i));
+        }
+    });
+
+    for (int i = 1; i <= NUM_ELEMENTS; i++) {
+        assert(*queue.pop() == i);
+    }
+    producer.join();
+    assert(queue.empty());
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a FixedQueue keeps FIFO order across many wraparounds without allocating.
+ */
+int fixedQueueWrapsAround() {
+    size_t before = allocations;
+    typed::FixedQueue<int, 4> queue;
+    static_assert(queue.capacity() == 4);
+    assert(queue.empty());
+    assert(!queue.try_pop().has_value());
+
+    int next = 1;
+    int expected = 1;
+    for (int round = 0; round < NUM_ELEMENTS; round++) {
+        while (queue.push(next)) {
+            next++;
+        }
+        assert(queue.size() == 4);
+        assert(queue.try_pop() == expected++);
+        assert(queue.try_pop() == expected++);
+        assert(queue.try_pop() == expected++);
+    }
+    while (std::optional<int> value = queue.try_pop()) {
+        assert(*value == expected++);
+    }
+    assert(expected == next);
+    assert(allocations == before);
+
+    return TEST_SUCCESS;
+}
+
+/*
+ * Checks that a global FixedQueue constructs in place, moves once on pop and destroys what is left.
+ */
+int fixedQueueElementLifetimes() {
+    assert(globalQueue.emplace(1));
+    assert(globalQueue.emplace(2));
+    assert(Tracked::live == 2);
+    assert(Tracked::copies == 0 && Tracked::moves == 0);
+
+    std::optional<Tracked> first = globalQueue.try_pop();
+    assert(first.has_value() && first->value == 1);
+    assert(Tracked::moves == 1);
+    assert(Tracked::live == 2);
+    first.reset();
+    assert(globalQueue.try_pop()->value == 2);
+    assert(Tracked::live == 0);
+
+    {
+        typed::FixedQueue<Tracked, 8> queue;
+        for (int i = 0; i < 5; i++) {
+            queue.emplace(i);
+        }
+        assert(Tracked::live == 5);
+    }
+    assert(Tracked::live == 0);
+
+    return TEST_SUCCESS;
+}
+
+
+/*
+ * Main function for the typed queue tests which will run each user-defined test in turn.
+ */
+
+int main() {
+    runTest(queueFifoAndBounds);
+    runTest(emplaceAndPopWithoutCopies);
+    runTest(pushPopWithoutAllocations);
+    runTest(moveOnlyElements);
+    runTest(destroyReleasesElements);
+    runTest(pushBlocksWhenFull);
+    runTest(tryEmplaceAfterOutOfOrderPop);
+    runTest(concurrentProducerConsumer);
+    runTest(concurrentProducersAndConsumers);
+    runTest(fixedQueueWrapsAround);
+    runTest(fixedQueueElementLifetimes);
+
+    printf("\nTypedQueue Tests complete: %d / %d tests successful.\n----------------\n", success_count, total_count);
+
+}
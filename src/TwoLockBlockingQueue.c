@@ -0,0 +1,154 @@
+/*
+ * TwoLockBlockingQueue.c
+ *
+ * Fixed-size generic ring-buffer BlockingQueue with separate head and tail locks.
+ *
+ */
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "TwoLockBlockingQueue.h"
+
+
+TwoLockBlockingQueue *new_TwoLockBlockingQueue(int max_size) {
+    if (max_size <= 0) {
+        return NULL;
+    }
+
+    TwoLockBlockingQueue* queue = (TwoLockBlockingQueue*) aligned_alloc(TWO_LOCK_CACHE_LINE,
+            sizeof(TwoLockBlockingQueue));
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    queue->array = (void**) malloc(sizeof(void*) * max_size);
+    if (queue->array == NULL) {
+        free(queue);
+        return NULL;
+    }
+
+    queue->maxSize = max_size;
+    atomic_init(&(queue->size), 0);
+    queue->head = 0;
+    queue->tail = 0;
+    pthread_mutex_init(&(queue->headMutex), NULL);
+    pthread_cond_init(&(queue->notEmpty), NULL);
+    atomic_init(&(queue->notEmptyWaiters), 0);
+    pthread_mutex_init(&(queue->tailMutex), NULL);
+    pthread_cond_init(&(queue->notFull), NULL);
+    atomic_init(&(queue->notFullWaiters), 0);
+
+    return queue;
+}
+
+/*
+ * Waits on cond, holding mutex, while the size is still full_size.
+ * The waiter is counted before the size is re-read, and the other side changes the size
+ * before reading the count, so either this thread sees the change or the other side sees
+ * the waiter and signals it.
+ */
+static void waitWhile(TwoLockBlockingQueue* this, int full_size, pthread_cond_t* cond, pthread_mutex_t* mutex,
+        atomic_int* waiters) {
+    while (atomic_load(&(this->size)) == full_size) {
+        atomic_fetch_add(waiters, 1);
+        if (atomic_load(&(this->size)) == full_size) {
+            pthread_cond_wait(cond, mutex);
+        }
+        atomic_fetch_sub(waiters, 1);
+    }
+}
+
+/*
+ * Wakes one thread waiting on cond under mutex, which the caller does not hold.
+ * Taking and releasing mutex first guarantees any thread that saw the old size is already
+ * waiting; signalling after releasing it lets the woken thread take mutex straight away.
+ */
+static void signalOther(pthread_cond_t* cond, pthread_mutex_t* mutex) {
+    pthread_mutex_lock(mutex);
+    pthread_mutex_unlock(mutex);
+    pthread_cond_signal(cond);
+}
+
+bool TwoLockBlockingQueue_enq(TwoLockBlockingQueue* this, void* element) {
+    if (element == NULL) {
+        return false;
+    }
+
+    pthread_mutex_lock(&(this->tailMutex));
+    waitWhile(this, this->maxSize, &(this->notFull), &(this->tailMutex), &(this->notFullWaiters));
+
+    this->array[this->tail] = element;
+    this->tail = (this->tail + 1 == this->maxSize) ? 0 : this->tail + 1;
+    int previous = atomic_fetch_add(&(this->size), 1);
+    /* Pass the wakeup on to the next producer while there is still space. */
+    bool cascade = previous + 1 < this->maxSize
+            && atomic_load_explicit(&(this->notFullWaiters), memory_order_relaxed) > 0;
+
+    pthread_mutex_unlock(&(this->tailMutex));
+    if (cascade) {
+        pthread_cond_signal(&(this->notFull));
+    }
+    if (previous == 0 && atomic_load(&(this->notEmptyWaiters)) > 0) {
+        signalOther(&(this->notEmpty), &(this->headMutex));
+    }
+
+    return true;
+}
+
+void* TwoLockBlockingQueue_deq(TwoLockBlockingQueue* this) {
+    void* data = NULL;
+    pthread_mutex_lock(&(this->headMutex));
+    waitWhile(this, 0, &(this->notEmpty), &(this->headMutex), &(this->notEmptyWaiters));
+
+    data = this->array[this->head];
+    this->head = (this->head + 1 == this->maxSize) ? 0 : this->head + 1;
+    int previous = atomic_fetch_sub(&(this->size), 1);
+    /* Pass the wakeup on to the next consumer while elements remain. */
+    bool cascade = previous > 1 && atomic_load_explicit(&(this->notEmptyWaiters), memory_order_relaxed) > 0;
+
+    pthread_mutex_unlock(&(this->headMutex));
+    if (cascade) {
+        pthread_cond_signal(&(this->notEmpty));
+    }
+    if (previous == this->maxSize && atomic_load(&(this->notFullWaiters)) > 0) {
+        signalOther(&(this->notFull), &(this->tailMutex));
+    }
+
+    return data;
+}
+
+int TwoLockBlockingQueue_size(TwoLockBlockingQueue* this) {
+    return atomic_load(&(this->size));
+}
+
+bool TwoLockBlockingQueue_isEmpty(TwoLockBlockingQueue* this) {
+    return atomic_load(&(this->size)) == 0;
+}
+
+void TwoLockBlockingQueue_clear(TwoLockBlockingQueue* this) {
+    /* Always lock head before tail so clear cannot deadlock against itself. */
+    pthread_mutex_lock(&(this->headMutex));
+    pthread_mutex_lock(&(this->tailMutex));
+
+    int size = atomic_load(&(this->size));
+    this->head = this->tail;
+    atomic_store(&(this->size), 0);
+    if (size == this->maxSize) {
+        pthread_cond_broadcast(&(this->notFull));
+    }
+
+    pthread_mutex_unlock(&(this->tailMutex));
+    pthread_mutex_unlock(&(this->headMutex));
+}
+
+void TwoLockBlockingQueue_destroy(TwoLockBlockingQueue* this) {
+    free(this->array);
+    pthread_mutex_destroy(&(this->headMutex));
+    pthread_cond_destroy(&(this->notEmpty));
+    pthread_mutex_destroy(&(this->tailMutex));
+    pthread_cond_destroy(&(this->notFull));
+    free(this);
+}
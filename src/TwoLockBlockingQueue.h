@@ -0,0 +1,89 @@
+/*
+ * TwoLockBlockingQueue.h
+ *
+ * Module interface for a generic fixed-size Blocking Queue with separate head and tail locks.
+ *
+ * Producers only take the tail lock and consumers only take the head lock, so a producer
+ * and a consumer never contend for the same mutex. The only state the two sides share is
+ * the atomic element count: each side blocks on a condition variable under its own lock,
+ * and only takes the other side's lock to wake it when the queue leaves empty or full.
+ *
+ */
+
+#ifndef TWO_LOCK_BLOCKING_QUEUE_H_
+#define TWO_LOCK_BLOCKING_QUEUE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#define TWO_LOCK_CACHE_LINE 64
+
+typedef struct TwoLockBlockingQueue TwoLockBlockingQueue;
+
+struct TwoLockBlockingQueue {
+    /* Read-only after creation. */
+    void **array;
+    int maxSize;
+
+    /* The only field written by both sides, kept on its own cache line. */
+    _Alignas(TWO_LOCK_CACHE_LINE) atomic_int size;
+
+    /* Consumer side, kept on its own cache line. */
+    _Alignas(TWO_LOCK_CACHE_LINE) pthread_mutex_t headMutex;
+    pthread_cond_t notEmpty;
+    /* Consumers waiting on notEmpty, so producers only take headMutex when someone needs waking. */
+    atomic_int notEmptyWaiters;
+    int head;
+
+    /* Producer side, kept on its own cache line. */
+    _Alignas(TWO_LOCK_CACHE_LINE) pthread_mutex_t tailMutex;
+    pthread_cond_t notFull;
+    /* Producers waiting on notFull, so consumers only take tailMutex when someone needs waking. */
+    atomic_int notFullWaiters;
+    int tail;
+};
+
+/*
+ * Creates a new TwoLockBlockingQueue for at most max_size void* elements.
+ * Returns a pointer to a new TwoLockBlockingQueue on success and NULL on failure.
+ */
+TwoLockBlockingQueue* new_TwoLockBlockingQueue(int max_size);
+
+/*
+ * Enqueues the given void* element at the back of this Queue.
+ * If the queue is full, the function will block the calling thread until there is space in the queue.
+ * Returns false when element is NULL and true on success.
+ */
+bool TwoLockBlockingQueue_enq(TwoLockBlockingQueue* this, void* element);
+
+/*
+ * Dequeues an element from the front of this Queue.
+ * If the queue is empty, the function will block until an element can be dequeued.
+ * Returns the dequeued void* element.
+ */
+void* TwoLockBlockingQueue_deq(TwoLockBlockingQueue* this);
+
+/*
+ * Returns the number of elements currently in this Queue.
+ */
+int TwoLockBlockingQueue_size(TwoLockBlockingQueue* this);
+
+/*
+ * Returns true if this Queue is empty, false otherwise.
+ */
+bool TwoLockBlockingQueue_isEmpty(TwoLockBlockingQueue* this);
+
+/*
+ * Clears this Queue returning it to an empty state.
+ */
+void TwoLockBlockingQueue_clear(TwoLockBlockingQueue* this);
+
+/*
+ * Destroys this Queue by freeing the memory used by the Queue.
+ */
+void TwoLockBlockingQueue_destroy(TwoLockBlockingQueue* this);
+
+#endif /* TWO_LOCK_BLOCKING_QUEUE_H_ */
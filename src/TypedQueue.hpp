@@ -0,0 +1,396 @@
+/*
+ * TypedQueue.hpp
+ *
+ * C++ class templates storing elements of type T directly in a Queue or BlockingQueue.
+ *
+ * Each container owns a fixed array of uninitialised slots, one per element of capacity,
+ * and the C queue only ever carries pointers to those slots. Push picks a free slot without
+ * asking the C queue, constructs T in place and enqueues the slot, and pop dequeues a slot
+ * and moves T out. Each operation therefore costs one C queue operation, pushing and popping
+ * never allocate, emplace never copies or moves, and pop moves the element exactly once.
+ *
+ * FixedQueue<T, N> instead fixes its power-of-two capacity at compile time and keeps its
+ * elements inline, so it never allocates and can live on the stack or be constinit global.
+ *
+ */
+
+#ifndef TYPED_QUEUE_HPP_
+#define TYPED_QUEUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include "BlockingQueue.h"
+#include "Queue.h"
+
+namespace typed {
+
+/*
+ * Uninitialised storage for one element of type T.
+ */
+template <typename T>
+struct alignas(T) Slot {
+    unsigned char bytes[sizeof(T)];
+
+    T* get() {
+        return std::launder(reinterpret_cast<T*>(bytes));
+    }
+};
+
+/*
+ * Fixed-capacity single-threaded FIFO queue of T, over the C Queue.
+ */
+template <typename T>
+class Queue {
+public:
+    /*
+     * Creates a queue for at most capacity elements.
+     * Throws std::bad_alloc if the queue cannot be created.
+     */
+    explicit Queue(size_t capacity)
+        : slots_(new Slot<T>[capacity]), used_(new_Queue(capacity)), tail_(0), capacity_(capacity) {
+        if (used_ == nullptr) {
+            throw std::bad_alloc();
+        }
+    }
+
+    Queue(const Queue&) = delete;
+    Queue& operator=(const Queue&) = delete;
+
+    /*
+     * Destroys every element still in the queue.
+     */
+    ~Queue() {
+        while (auto* slot = static_cast<Slot<T>*>(Queue_deq(used_))) {
+            slot->get()->~T();
+        }
+        Queue_destroy(used_);
+    }
+
+    /*
+     * Constructs an element in place at the back of the queue.
+     * Returns false, without constructing, if the queue is full.
+     */
+    template <typename... Args>
+    bool emplace(Args&&... args) {
+        /* Slots leave the C queue in the order they entered it, so the one at tail_ is free unless it is full. */
+        if (Queue_size(used_) == capacity_) {
+            return false;
+        }
+        Slot<T>* slot = &slots_[tail_];
+        ::new (static_cast<void*>(slot->bytes)) T(std::forward<Args>(args)...);
+        Queue_enq(used_, slot);
+        tail_ = tail_ + 1 == capacity_ ? 0 : tail_ + 1;
+        return true;
+    }
+
+    /*
+     * Moves or copies value to the back of the queue. Returns false if the queue is full.
+     */
+    bool push(const T& value) {
+        return emplace(value);
+    }
+
+    bool push(T&& value) {
+        return emplace(std::move(value));
+    }
+
+    /*
+     * Moves the front element out of the queue.
+     * Returns std::nullopt if the queue is empty.
+     */
+    std::optional<T> try_pop() {
+        std::optional<T> value;
+        if (auto* slot = static_cast<Slot<T>*>(Queue_deq(used_))) {
+            value.emplace(std::move(*slot->get()));
+            slot->get()->~T();
+        }
+        return value;
+    }
+
+    size_t size() const {
+        return Queue_size(used_);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+private:
+    std::unique_ptr<Slot<T>[]> slots_;
+    ::Queue* used_;
+    size_t tail_;
+    size_t capacity_;
+};
+
+/*
+ * Fixed-capacity thread-safe blocking FIFO queue of T, over the C BlockingQueue.
+ * push/emplace block while the queue is full and pop blocks while it is empty.
+ *
+ * The queue is full while capacity elements are being pushed, queued or popped: a producer
+ * claims one unit of an atomic count before taking a slot and pop returns it once the element
+ * has been moved out. A claimed unit guarantees a free slot, which the producer finds by probing
+ * from a rotating start, so at most capacity slots are ever in the C queue and its enq never
+ * blocks. Full blocking waits on the count; empty blocking is the C queue's.
+ */
+template <typename T>
+class BlockingQueue {
+public:
+    /*
+     * Creates a queue for at most capacity elements, which must be at least 1.
+     * Throws std::invalid_argument for a capacity of 0 and std::bad_alloc if the queue cannot be created.
+     */
+    explicit BlockingQueue(size_t capacity)
+        : slots_(new ClaimedSlot[capacity]), used_(nullptr), claimed_(0), next_(0), capacity_(capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("typed::BlockingQueue capacity must be at least 1");
+        }
+        used_ = new_BlockingQueue(capacity);
+        if (used_ == nullptr) {
+            throw std::bad_alloc();
+        }
+    }
+
+    BlockingQueue(const BlockingQueue&) = delete;
+    BlockingQueue& operator=(const BlockingQueue&) = delete;
+
+    /*
+     * Destroys every element still in the queue. No thread may be using the queue.
+     */
+    ~BlockingQueue() {
+        while (auto* slot = static_cast<ClaimedSlot*>(BlockingQueue_tryDeq(used_))) {
+            slot->get()->~T();
+        }
+        BlockingQueue_destroy(used_);
+    }
+
+    /*
+     * Constructs an element in place at the back of the queue, blocking while it is full.
+     */
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        size_t claimed = claimed_.load(std::memory_order_relaxed);
+        for (;;) {
+            if (claimed == capacity_) {
+                claimed_.wait(claimed, std::memory_order_relaxed);
+                claimed = claimed_.load(std::memory_order_relaxed);
+            } else if (claimed_.compare_exchange_weak(claimed, claimed + 1, std::memory_order_acquire)) {
+                break;
+            }
+        }
+        construct(std::forward<Args>(args)...);
+    }
+
+    /*
+     * Constructs an element in place at the back of the queue if there is space.
+     * Returns false, without constructing, if the queue is full.
+     */
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        size_t claimed = claimed_.load(std::memory_order_relaxed);
+        do {
+            if (claimed == capacity_) {
+                return false;
+            }
+        } while (!claimed_.compare_exchange_weak(claimed, claimed + 1, std::memory_order_acquire));
+        construct(std::forward<Args>(args)...);
+        return true;
+    }
+
+    /*
+     * Moves or copies value to the back of the queue, blocking while it is full.
+     */
+    void push(const T& value) {
+        emplace(value);
+    }
+
+    void push(T&& value) {
+        emplace(std::move(value));
+    }
+
+    /*
+     * Moves the front element out of the queue, blocking while it is empty.
+     */
+    T pop() {
+        auto* slot = static_cast<ClaimedSlot*>(BlockingQueue_deq(used_));
+        T value(std::move(*slot->get()));
+        slot->get()->~T();
+        vacate(slot);
+        return value;
+    }
+
+    /*
+     * Moves the front element out of the queue without blocking.
+     * Returns std::nullopt if the queue is empty.
+     */
+    std::optional<T> try_pop() {
+        std::optional<T> value;
+        if (auto* slot = static_cast<ClaimedSlot*>(BlockingQueue_tryDeq(used_))) {
+            value.emplace(std::move(*slot->get()));
+            slot->get()->~T();
+            vacate(slot);
+        }
+        return value;
+    }
+
+    size_t size() const {
+        return BlockingQueue_size(used_);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+private:
+    /*
+     * Element storage with a flag set while a producer or the C queue holds it.
+     */
+    struct ClaimedSlot : Slot<T> {
+        std::atomic<bool> taken;
+    };
+
+    /*
+     * Takes a free slot, constructs an element in it and enqueues it.
+     * Must be called after claiming a unit of claimed_, which guarantees a slot is free.
+     */
+    template <typename... Args>
+    void construct(Args&&... args) {
+        size_t index = next_.fetch_add(1, std::memory_order_relaxed) % capacity_;
+        ClaimedSlot* slot = &slots_[index];
+        while (slot->taken.load(std::memory_order_relaxed)
+                || slot->taken.exchange(true, std::memory_order_acquire)) {
+            /* Slots are vacated out of order when producers enqueue out of order; probe on. */
+            index = index + 1 == capacity_ ? 0 : index + 1;
+            slot = &slots_[index];
+        }
+
+        try {
+            ::new (static_cast<void*>(slot->bytes)) T(std::forward<Args>(args)...);
+        } catch (...) {
+            vacate(slot);
+            throw;
+        }
+        BlockingQueue_enq(used_, slot);
+    }
+
+    /*
+     * Frees an empty slot and returns its unit of claimed_, waking a blocked producer.
+     */
+    void vacate(ClaimedSlot* slot) {
+        slot->taken.store(false, std::memory_order_release);
+        claimed_.fetch_sub(1, std::memory_order_release);
+        claimed_.notify_one();
+    }
+
+    std::unique_ptr<ClaimedSlot[]> slots_;
+    ::BlockingQueue* used_;
+    std::atomic<size_t> claimed_;
+    std::atomic<size_t> next_;
+    size_t capacity_;
+};
+
+/*
+ * Single-threaded FIFO queue of at most N elements of T stored inline, with no C queue underneath.
+ * N must be a power of two, so head and tail count up freely and are masked into the array.
+ */
+template <typename T, size_t N>
+    requires(N > 0 && (N & (N - 1)) == 0)
+class FixedQueue {
+public:
+    /*
+     * Creates an empty queue. Only the counters are initialised, so this is a constant expression.
+     */
+    constexpr FixedQueue() noexcept : unused_(), head_(0), tail_(0) {
+    }
+
+    FixedQueue(const FixedQueue&) = delete;
+    FixedQueue& operator=(const FixedQueue&) = delete;
+
+    /*
+     * Destroys every element still in the queue.
+     */
+    ~FixedQueue() {
+        while (head_ != tail_) {
+            std::destroy_at(&items_[head_++ & MASK]);
+        }
+    }
+
+    /*
+     * Constructs an element in place at the back of the queue.
+     * Returns false, without constructing, if the queue is full.
+     */
+    template <typename... Args>
+    bool emplace(Args&&... args) {
+        if (tail_ - head_ == N) {
+            return false;
+        }
+        std::construct_at(&items_[tail_ & MASK], std::forward<Args>(args)...);
+        tail_++;
+        return true;
+    }
+
+    /*
+     * Moves or copies value to the back of the queue. Returns false if the queue is full.
+     */
+    bool push(const T& value) {
+        return emplace(value);
+    }
+
+    bool push(T&& value) {
+        return emplace(std::move(value));
+    }
+
+    /*
+     * Moves the front element out of the queue.
+     * Returns std::nullopt if the queue is empty.
+     */
+    std::optional<T> try_pop() {
+        std::optional<T> value;
+        if (head_ != tail_) {
+            T* item = &items_[head_++ & MASK];
+            value.emplace(std::move(*item));
+            std::destroy_at(item);
+        }
+        return value;
+    }
+
+    size_t size() const {
+        return tail_ - head_;
+    }
+
+    bool empty() const {
+        return head_ == tail_;
+    }
+
+    static constexpr size_t capacity() {
+        return N;
+    }
+
+private:
+    static constexpr size_t MASK = N - 1;
+
+    /* Only the elements between head_ and tail_ are ever constructed in items_. */
+    union {
+        char unused_;
+        T items_[N];
+    };
+    size_t head_;
+    size_t tail_;
+};
+
+} // namespace typed
+
+#endif /* TYPED_QUEUE_HPP_ */